@@ -0,0 +1,100 @@
+#include "allocation_counter.h"
+#include "benchmark_functions.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+#ifdef RUN_BENCHMARKS
+// Заменяются все варианты сразу, чтобы ни одно выделение не прошло мимо счётчика
+static atomic<size_t> allocation_count = 0;
+
+static void* CountedAllocate(size_t size, size_t alignment) noexcept {
+    allocation_count.fetch_add(1, memory_order_relaxed);
+    if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+        return malloc(size == 0 ? 1 : size);
+    }
+    // aligned_alloc требует размер, кратный выравниванию
+    return aligned_alloc(alignment, (max(size, size_t{1}) + alignment - 1) / alignment * alignment);
+}
+
+static void* CountedAllocateOrThrow(size_t size, size_t alignment) {
+    if (void* ptr = CountedAllocate(size, alignment)) {
+        return ptr;
+    }
+    throw bad_alloc();
+}
+
+void* operator new(size_t size) {
+    return CountedAllocateOrThrow(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void* operator new[](size_t size) {
+    return CountedAllocateOrThrow(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void* operator new(size_t size, align_val_t alignment) {
+    return CountedAllocateOrThrow(size, static_cast<size_t>(alignment));
+}
+void* operator new[](size_t size, align_val_t alignment) {
+    return CountedAllocateOrThrow(size, static_cast<size_t>(alignment));
+}
+void* operator new(size_t size, const nothrow_t&) noexcept {
+    return CountedAllocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void* operator new[](size_t size, const nothrow_t&) noexcept {
+    return CountedAllocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void* operator new(size_t size, align_val_t alignment, const nothrow_t&) noexcept {
+    return CountedAllocate(size, static_cast<size_t>(alignment));
+}
+void* operator new[](size_t size, align_val_t alignment, const nothrow_t&) noexcept {
+    return CountedAllocate(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+void operator delete[](void* ptr) noexcept {
+    free(ptr);
+}
+void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+void operator delete[](void* ptr, size_t) noexcept {
+    free(ptr);
+}
+void operator delete(void* ptr, align_val_t) noexcept {
+    free(ptr);
+}
+void operator delete[](void* ptr, align_val_t) noexcept {
+    free(ptr);
+}
+void operator delete(void* ptr, size_t, align_val_t) noexcept {
+    free(ptr);
+}
+void operator delete[](void* ptr, size_t, align_val_t) noexcept {
+    free(ptr);
+}
+void operator delete(void* ptr, const nothrow_t&) noexcept {
+    free(ptr);
+}
+void operator delete[](void* ptr, const nothrow_t&) noexcept {
+    free(ptr);
+}
+void operator delete(void* ptr, align_val_t, const nothrow_t&) noexcept {
+    free(ptr);
+}
+void operator delete[](void* ptr, align_val_t, const nothrow_t&) noexcept {
+    free(ptr);
+}
+
+size_t GetAllocationCount() {
+    return allocation_count.load(memory_order_relaxed);
+}
+#else
+size_t GetAllocationCount() {
+    return 0;
+}
+#endif
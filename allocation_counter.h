@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstddef>
+
+// Число выделений памяти глобальным operator new с начала программы, для BenchmarkAllocations.
+// Операторы new и delete заменяются во всей программе, только когда включены бенчмарки
+// (RUN_BENCHMARKS), иначе счётчик всегда 0. Замена вынесена в отдельный файл: если тело
+// operator delete встраивается в код, выделивший память через new, GCC ошибочно предупреждает
+// о несовпадении new и free
+size_t GetAllocationCount();
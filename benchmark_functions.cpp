@@ -0,0 +1,900 @@
+#include "benchmark_functions.h"
+#include "allocation_counter.h"
+#include "bulk_loader.h"
+#include "duplicate_detector.h"
+#include "log_duration.h"
+#include "mapped_search_server.h"
+#include "metrics.h"
+#include "process_queries.h"
+#include "query_arena.h"
+#include "query_result_cache.h"
+#include "relevance_accumulator.h"
+#include "request_queue.h"
+#include "search_server.h"
+#include "sharded_search_server.h"
+#include "snapshot_search_server.h"
+#include "string_processing.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <thread>
+#include <tuple>
+
+using namespace std;
+
+string GenerateWord(mt19937& generator, int max_length) {
+    const int length = uniform_int_distribution(1, max_length)(generator);
+    string word;
+    word.reserve(length);
+    for (int i = 0; i < length; ++i) {
+        word.push_back(uniform_int_distribution('a', 'z')(generator));
+    }
+    return word;
+}
+
+vector<string> GenerateDictionary(mt19937& generator, int word_count, int max_length) {
+    vector<string> words;
+    words.reserve(word_count);
+    for (int i = 0; i < word_count; ++i) {
+        words.push_back(GenerateWord(generator, max_length));
+    }
+    sort(words.begin(), words.end());
+    words.erase(unique(words.begin(), words.end()), words.end());
+    return words;
+}
+
+string GenerateQuery(mt19937& generator, const vector<string>& dictionary, int word_count, double minus_prob) {
+    string query;
+    for (int i = 0; i < word_count; ++i) {
+        if (!query.empty()) {
+            query.push_back(' ');
+        }
+        if (uniform_real_distribution<>(0, 1)(generator) < minus_prob) {
+            query.push_back('-');
+        }
+        query += dictionary[uniform_int_distribution<int>(0, dictionary.size() - 1)(generator)];
+    }
+    return query;
+}
+
+vector<string> GenerateQueries(mt19937& generator, const vector<string>& dictionary, int query_count, int max_word_count) {
+    vector<string> queries;
+    queries.reserve(query_count);
+    for (int i = 0; i < query_count; ++i) {
+        queries.push_back(GenerateQuery(generator, dictionary, max_word_count));
+    }
+    return queries;
+}
+
+vector<string> GenerateZipfTexts(mt19937& generator, const vector<string>& dictionary, int text_count, int word_count, double exponent) {
+    vector<double> weights(dictionary.size());
+    for (size_t rank = 0; rank < weights.size(); ++rank) {
+        weights[rank] = 1.0 / pow(rank + 1, exponent);
+    }
+    discrete_distribution<size_t> word_distribution(weights.begin(), weights.end());
+    vector<string> texts;
+    texts.reserve(text_count);
+    for (int i = 0; i < text_count; ++i) {
+        string text;
+        for (int j = 0; j < word_count; ++j) {
+            if (!text.empty()) {
+                text.push_back(' ');
+            }
+            text += dictionary[word_distribution(generator)];
+        }
+        texts.push_back(move(text));
+    }
+    return texts;
+}
+
+size_t GetResidentMemoryKb() {
+    ifstream status("/proc/self/status"s);
+    string line;
+    while (getline(status, line)) {
+        if (line.rfind("VmRSS:"s, 0) == 0) {
+            return stoul(line.substr(6));
+        }
+    }
+    return 0;
+}
+
+void BenchmarkProcessQueries() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 2'000, 25);
+    const auto documents = GenerateQueries(generator, dictionary, 20'000, 10);
+
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+
+    const auto queries = GenerateQueries(generator, dictionary, 2'000, 7);
+    size_t serial_total = 0;
+    {
+        LOG_DURATION("ProcessQueries serial loop"s);
+        for (const string& query : queries) {
+            serial_total += search_server.FindTopDocuments(query).size();
+        }
+    }
+    size_t parallel_total = 0;
+    {
+        LOG_DURATION("ProcessQueries"s);
+        for (const auto& documents : ProcessQueries(search_server, queries)) {
+            parallel_total += documents.size();
+        }
+    }
+    size_t joined_total = 0;
+    {
+        LOG_DURATION("ProcessQueriesJoined"s);
+        for ([[maybe_unused]] const Document& document : ProcessQueriesJoined(search_server, queries)) {
+            ++joined_total;
+        }
+    }
+    cerr << "Found documents: "s << serial_total << " / "s << parallel_total << " / "s << joined_total << endl;
+}
+
+void BenchmarkIndexBuild() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 20'000, 12);
+    const auto documents = GenerateQueries(generator, dictionary, 100'000, 40);
+    const auto queries = GenerateQueries(generator, dictionary, 1'000, 5);
+
+    const size_t memory_before = GetResidentMemoryKb();
+    SearchServer search_server(dictionary[0]);
+    {
+        LOG_DURATION("AddDocument x100000"s);
+        for (size_t i = 0; i < documents.size(); ++i) {
+            search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+        }
+    }
+    cerr << "Index memory: "s << GetResidentMemoryKb() - memory_before << " KB"s << endl;
+    size_t found = 0;
+    {
+        LOG_DURATION("FindTopDocuments x1000"s);
+        for (const string& query : queries) {
+            found += search_server.FindTopDocuments(query).size();
+        }
+    }
+    cerr << "Found documents: "s << found << endl;
+}
+
+void BenchmarkRemoveDocuments() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 20'000, 12);
+    const auto documents = GenerateQueries(generator, dictionary, 20'000, 40);
+
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+    {
+        LOG_DURATION("RemoveDocument x5000"s);
+        for (int id = 0; id < 10'000; id += 2) {
+            search_server.RemoveDocument(id);
+        }
+    }
+    {
+        LOG_DURATION("RemoveDocuments x5000"s);
+        vector<int> document_ids;
+        for (int id = 1; id < 10'000; id += 2) {
+            document_ids.push_back(id);
+        }
+        search_server.RemoveDocuments(document_ids);
+    }
+    cerr << "Documents left: "s << search_server.GetDocumentCount() << endl;
+}
+
+void BenchmarkMaxScore() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 50'000, 12);
+    const auto documents = GenerateZipfTexts(generator, dictionary, 100'000, 50);
+    SearchServer search_server(""s);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {static_cast<int>(i % 10)});
+    }
+
+    const auto run_queries = [&search_server](const vector<string>& queries, QueryEvaluation query_evaluation,
+                                              size_t& postings_total, size_t& postings_scored) {
+        search_server.SetQueryEvaluation(query_evaluation);
+        const auto start = chrono::steady_clock::now();
+        for (const string& query : queries) {
+            search_server.FindTopDocuments(query);
+            postings_total += SearchServer::GetLastQueryStats().postings_total;
+            postings_scored += SearchServer::GetLastQueryStats().postings_scored;
+        }
+        return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count() / queries.size();
+    };
+    for (int word_count = 2; word_count <= 10; word_count += 2) {
+        const auto queries = GenerateZipfTexts(generator, dictionary, 200, word_count);
+        size_t exhaustive_total = 0, exhaustive_scored = 0, max_score_total = 0, max_score_scored = 0;
+        const auto exhaustive_us = run_queries(queries, QueryEvaluation::EXHAUSTIVE, exhaustive_total, exhaustive_scored);
+        const auto max_score_us = run_queries(queries, QueryEvaluation::MAX_SCORE, max_score_total, max_score_scored);
+        cerr << word_count << " words: exhaustive "s << exhaustive_us << " us/query, MaxScore "s << max_score_us
+             << " us/query, postings skipped "s << 100.0 * (max_score_total - max_score_scored) / max_score_total << "%"s << endl;
+    }
+    search_server.SetQueryEvaluation(QueryEvaluation::EXHAUSTIVE);
+}
+
+void BenchmarkSplitIntoWords() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 50'000, 12);
+    const auto documents = GenerateZipfTexts(generator, dictionary, 100'000, 60);
+    size_t total_bytes = 0;
+    for (const string& document : documents) {
+        total_bytes += document.size();
+    }
+    cerr << "SplitIntoWords: "s << documents.size() << " documents, "s << total_bytes / documents.size() << " bytes on average"s << endl;
+
+    const auto run = [&documents](const string& name, BoundaryScanner scanner) {
+        size_t word_count = 0;
+        LOG_DURATION("SplitIntoWords "s + name);
+        for (int repeat = 0; repeat < 10; ++repeat) {
+            for (const string& document : documents) {
+                word_count += SplitIntoWords(document, scanner).size();
+            }
+        }
+        return word_count;
+    };
+    run("scalar"s, ScanBoundariesScalar);
+#if defined(__x86_64__) || defined(__i386__)
+    run("SSE2"s, ScanBoundariesSse2);
+    if (__builtin_cpu_supports("avx2")) {
+        run("AVX2"s, ScanBoundariesAvx2);
+    }
+#endif
+}
+
+// Смешанная нагрузка: на каждые 9 запросов приходится одно добавление документа
+template <typename AddFunc, typename FindFunc>
+static double RunMixedWorkload(int thread_count, const vector<string>& documents, const vector<string>& queries,
+                               AddFunc add_document, FindFunc find_top_documents) {
+    static int run_index = 0;
+    const int first_document_id = 1'000'000 * ++run_index;
+    const int operations_per_thread = 2'000;
+    const auto start = chrono::steady_clock::now();
+    vector<thread> threads;
+    for (int t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < operations_per_thread; ++i) {
+                if (i % 10 == 0) {
+                    const int document_id = first_document_id + t * operations_per_thread + i;
+                    add_document(document_id, documents[document_id % documents.size()]);
+                } else {
+                    find_top_documents(queries[(t * operations_per_thread + i) % queries.size()]);
+                }
+            }
+        });
+    }
+    for (thread& worker : threads) {
+        worker.join();
+    }
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return thread_count * operations_per_thread / seconds;
+}
+
+void BenchmarkShardedSearchServer() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 20'000, 12);
+    const auto documents = GenerateZipfTexts(generator, dictionary, 50'000, 40);
+    const auto queries = GenerateQueries(generator, dictionary, 1'000, 3);
+
+    SearchServer search_server(""s);
+    ShardedSearchServer sharded_server(""s, 16);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1});
+        sharded_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1});
+    }
+    mutex search_server_mutex;
+    const int max_threads = max(4u, thread::hardware_concurrency());
+    for (int thread_count = 1; thread_count <= max_threads; thread_count *= 2) {
+        const double global_lock_ops = RunMixedWorkload(thread_count, documents, queries,
+            [&](int document_id, const string& document) {
+                lock_guard guard(search_server_mutex);
+                search_server.AddDocument(document_id, document, DocumentStatus::ACTUAL, {1});
+            },
+            [&](const string& query) {
+                lock_guard guard(search_server_mutex);
+                return search_server.FindTopDocuments(query);
+            });
+        const double sharded_ops = RunMixedWorkload(thread_count, documents, queries,
+            [&](int document_id, const string& document) {
+                sharded_server.AddDocument(document_id, document, DocumentStatus::ACTUAL, {1});
+            },
+            [&](const string& query) {
+                return sharded_server.FindTopDocuments(query);
+            });
+        cerr << thread_count << " threads: global mutex "s << static_cast<int>(global_lock_ops) << " ops/s, sharded "s
+             << static_cast<int>(sharded_ops) << " ops/s"s << endl;
+    }
+}
+
+// Задержки запросов, выполняемых в reader_count потоках, пока один писатель добавляет вторую половину документов
+struct IngestLatency {
+    double documents_per_second;
+    vector<double> query_latencies;
+};
+
+template <typename AddFunc, typename FindFunc>
+static IngestLatency MeasureLatencyUnderIngest(int reader_count, const vector<string>& documents, const vector<string>& queries,
+                                                AddFunc add_document, FindFunc find_top_documents) {
+    const size_t preloaded_count = documents.size() / 2;
+    for (size_t i = 0; i < preloaded_count; ++i) {
+        add_document(static_cast<int>(i), documents[i]);
+    }
+    atomic_bool is_writing = true;
+    vector<vector<double>> reader_latencies(reader_count);
+    vector<thread> readers;
+    for (int t = 0; t < reader_count; ++t) {
+        readers.emplace_back([&, t]() {
+            for (size_t i = t; is_writing; ++i) {
+                const auto start = chrono::steady_clock::now();
+                find_top_documents(queries[i % queries.size()]);
+                reader_latencies[t].push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+            }
+        });
+    }
+    const auto ingest_start = chrono::steady_clock::now();
+    for (size_t i = preloaded_count; i < documents.size(); ++i) {
+        add_document(static_cast<int>(i), documents[i]);
+    }
+    const double ingest_seconds = chrono::duration<double>(chrono::steady_clock::now() - ingest_start).count();
+    is_writing = false;
+    for (thread& reader : readers) {
+        reader.join();
+    }
+    vector<double> latencies;
+    for (const vector<double>& reader_latency : reader_latencies) {
+        latencies.insert(latencies.end(), reader_latency.begin(), reader_latency.end());
+    }
+    sort(latencies.begin(), latencies.end());
+    return {(documents.size() - preloaded_count) / ingest_seconds, move(latencies)};
+}
+
+static void PrintLatencyPercentiles(const string& title, const IngestLatency& result) {
+    const vector<double>& latencies = result.query_latencies;
+    const auto percentile = [&latencies](double p) {
+        return latencies.empty() ? 0.0 : latencies[static_cast<size_t>(p * (latencies.size() - 1))];
+    };
+    cerr << title << ": "s << static_cast<int>(result.documents_per_second) << " docs/s ingested, "s
+         << latencies.size() << " queries, p50 "s << percentile(0.5) << " us, p99 "s
+         << percentile(0.99) << " us, max "s << percentile(1.0) << " us"s << endl;
+}
+
+void BenchmarkSnapshotSearchServer() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 20'000, 12);
+    const auto documents = GenerateZipfTexts(generator, dictionary, 20'000, 40);
+    const auto queries = GenerateQueries(generator, dictionary, 1'000, 3);
+    const int reader_count = 2;
+
+    SearchServer search_server(""s);
+    shared_mutex search_server_mutex;
+    PrintLatencyPercentiles("Reader/writer lock"s, MeasureLatencyUnderIngest(reader_count, documents, queries,
+        [&](int document_id, const string& document) {
+            unique_lock lock(search_server_mutex);
+            search_server.AddDocument(document_id, document, DocumentStatus::ACTUAL, {1});
+        },
+        [&](const string& query) {
+            shared_lock lock(search_server_mutex);
+            return search_server.FindTopDocuments(query);
+        }));
+
+    // Размер буфера и коэффициент слияния задают компромисс между скоростью записи и числом сегментов в запросе;
+    // огромный коэффициент фактически отключает слияние
+    const vector<pair<size_t, size_t>> configurations = {{1'000, 1'000'000}, {250, 4}, {1'000, 4}, {4'000, 4}, {1'000, 8}};
+    for (const auto& [max_buffered_changes, merge_factor] : configurations) {
+        SnapshotSearchServer snapshot_server(""s, max_buffered_changes, merge_factor);
+        const IngestLatency result = MeasureLatencyUnderIngest(reader_count, documents, queries,
+            [&](int document_id, const string& document) {
+                snapshot_server.AddDocument(document_id, document, DocumentStatus::ACTUAL, {1});
+            },
+            [&](const string& query) {
+                return snapshot_server.FindTopDocuments(query);
+            });
+        PrintLatencyPercentiles("Snapshots, buffer "s + to_string(max_buffered_changes) + ", merge factor "s + to_string(merge_factor)
+                                + ", "s + to_string(snapshot_server.GetSegmentCount()) + " segments"s, result);
+    }
+}
+
+// Холодный старт: построение индекса из текстов против отображения сохранённого файла.
+// Файл только что записан и лежит в кэше страниц, так что время чтения с диска здесь не учтено
+void BenchmarkMappedSearchServer() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 20'000, 12);
+    const auto documents = GenerateZipfTexts(generator, dictionary, 100'000, 40);
+    const auto queries = GenerateQueries(generator, dictionary, 1'000, 3);
+    const string path = (filesystem::temp_directory_path() / "search_server_benchmark.idx"s).string();
+    const auto seconds_since = [](chrono::steady_clock::time_point start) {
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    };
+
+    auto start = chrono::steady_clock::now();
+    SearchServer search_server(""s);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+    const double build_ms = seconds_since(start);
+    start = chrono::steady_clock::now();
+    search_server.FindTopDocuments(queries[0]);
+    const double built_first_query_ms = seconds_since(start);
+    start = chrono::steady_clock::now();
+    SaveIndex(search_server, path);
+    cerr << "Build from text: "s << build_ms << " ms, first query "s << built_first_query_ms << " ms, save "s
+         << seconds_since(start) << " ms, file "s << filesystem::file_size(path) / 1024 << " KB"s << endl;
+
+    start = chrono::steady_clock::now();
+    const MappedSearchServer mapped_server(path);
+    const double open_ms = seconds_since(start);
+    start = chrono::steady_clock::now();
+    mapped_server.FindTopDocuments(queries[0]);
+    cerr << "Mapped file: open "s << open_ms << " ms, first query "s << seconds_since(start) << " ms"s << endl;
+
+    size_t found = 0;
+    start = chrono::steady_clock::now();
+    for (const string& query : queries) {
+        found += search_server.FindTopDocuments(query).size();
+    }
+    cerr << "FindTopDocuments x1000: SearchServer "s << seconds_since(start) << " ms"s;
+    start = chrono::steady_clock::now();
+    for (const string& query : queries) {
+        found -= mapped_server.FindTopDocuments(query).size();
+    }
+    cerr << ", MappedSearchServer "s << seconds_since(start) << " ms, result difference "s << found << endl;
+    filesystem::remove(path);
+}
+
+void BenchmarkBulkLoader() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 20'000, 12);
+    const auto documents = GenerateZipfTexts(generator, dictionary, 100'000, 40);
+    const string path = (filesystem::temp_directory_path() / "search_server_benchmark.tsv"s).string();
+    {
+        ofstream output(path, ios::binary);
+        for (size_t i = 0; i < documents.size(); ++i) {
+            WriteDocumentLine(output, i, DocumentStatus::ACTUAL, {1, 2, 3}, documents[i]);
+        }
+    }
+    const double megabytes = filesystem::file_size(path) / (1024.0 * 1024.0);
+
+    const auto start = chrono::steady_clock::now();
+    SearchServer search_server(""s);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cerr << "AddDocument loop: "s << static_cast<int>(documents.size() / seconds) << " docs/s"s << endl;
+
+    const int max_threads = max(4u, thread::hardware_concurrency());
+    for (int worker_count = 1; worker_count <= max_threads; worker_count *= 2) {
+        SearchServer loaded_server(""s);
+        BulkLoadOptions options;
+        options.worker_count = worker_count;
+        const BulkLoadStats stats = LoadDocuments(loaded_server, path, options);
+        cerr << "LoadDocuments, "s << worker_count << " workers: "s << static_cast<int>(stats.document_count / stats.seconds)
+             << " docs/s, "s << megabytes / stats.seconds << " MB/s"s << endl;
+    }
+    filesystem::remove(path);
+}
+
+
+void BenchmarkRelevanceAccumulator() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 50'000, 12);
+    const auto documents = GenerateZipfTexts(generator, dictionary, 100'000, 50);
+    // Ранг слова по Ципфу совпадает с его местом в словаре: запросы из первых слов затрагивают много документов
+    const vector<string> frequent_words(dictionary.begin(), dictionary.begin() + 200);
+    vector<string> queries;
+    for (int i = 0; i < 300; ++i) {
+        queries.push_back(GenerateQuery(generator, frequent_words, 5, 0.2));
+    }
+    for (const int id_step : {1, 1000}) {
+        SearchServer search_server(""s);
+        for (size_t i = 0; i < documents.size(); ++i) {
+            search_server.AddDocument(i * id_step, documents[i], DocumentStatus::ACTUAL, {static_cast<int>(i % 10)});
+        }
+        size_t postings_total = 0;
+        const auto start = chrono::steady_clock::now();
+        for (const string& query : queries) {
+            search_server.FindTopDocuments(query);
+            postings_total += SearchServer::GetLastQueryStats().postings_total;
+        }
+        const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cerr << "Document id step "s << id_step << ": "s << queries.size() / seconds << " queries/s, "s
+             << postings_total / queries.size() << " postings per query"s << endl;
+    }
+
+    // Накопители по отдельности на случайных списках с разной долей затронутых документов
+    const int document_id_bound = 1'000'000;
+    for (const int slots_per_posting : {1, 4, 16, 64, 256, 1024}) {
+        vector<int> document_ids(document_id_bound / slots_per_posting);
+        for (int& document_id : document_ids) {
+            document_id = uniform_int_distribution<int>(0, document_id_bound - 1)(generator);
+        }
+        const auto measure = [&document_ids](const auto& accumulate) {
+            const auto start = chrono::steady_clock::now();
+            size_t result_size = 0;
+            for (int repeat = 0; repeat < 10; ++repeat) {
+                result_size += accumulate();
+            }
+            return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / (10 * document_ids.size());
+        };
+        const double map_ns = measure([&document_ids] {
+            map<int, double> document_to_relevance;
+            for (const int document_id : document_ids) {
+                document_to_relevance[document_id] += 1.0;
+            }
+            return document_to_relevance.size();
+        });
+        const auto measure_strategy = [&](RelevanceAccumulator::Strategy strategy) {
+            return measure([&document_ids, strategy] {
+                QueryArena arena;
+                RelevanceAccumulator accumulator(strategy, document_id_bound, document_ids.size(), arena.GetResource());
+                for (const int document_id : document_ids) {
+                    accumulator.Add(document_id, 1.0);
+                }
+                return accumulator.Extract().size();
+            });
+        };
+        cerr << document_id_bound << " ids, 1 posting per "s << slots_per_posting << " ids: map "s << map_ns << " ns/posting, dense "s
+             << measure_strategy(RelevanceAccumulator::Strategy::DENSE) << ", hash "s
+             << measure_strategy(RelevanceAccumulator::Strategy::HASH) << endl;
+    }
+}
+
+
+void BenchmarkStatusFilter() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 50'000, 12);
+    const auto documents = GenerateZipfTexts(generator, dictionary, 100'000, 50);
+    const auto queries = GenerateZipfTexts(generator, dictionary, 300, 4);
+    // Актуальны 20% документов, остальные поровну IRRELEVANT и BANNED
+    SearchServer search_server(""s);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        const DocumentStatus status = i % 5 == 0 ? DocumentStatus::ACTUAL : i % 2 ? DocumentStatus::IRRELEVANT : DocumentStatus::BANNED;
+        search_server.AddDocument(i, documents[i], status, {static_cast<int>(i % 10)});
+    }
+    const auto run_queries = [&search_server, &queries](const auto& find_top_documents) {
+        const auto start = chrono::steady_clock::now();
+        for (const string& query : queries) {
+            find_top_documents(query);
+        }
+        return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count() / queries.size();
+    };
+    for (const QueryEvaluation query_evaluation : {QueryEvaluation::EXHAUSTIVE, QueryEvaluation::MAX_SCORE}) {
+        search_server.SetQueryEvaluation(query_evaluation);
+        const auto predicate_us = run_queries([&search_server](const string& query) {
+            return search_server.FindTopDocuments(query, [](int, DocumentStatus status, int) { return status == DocumentStatus::ACTUAL; });
+        });
+        const auto prefilter_us = run_queries([&search_server](const string& query) {
+            return search_server.FindTopDocuments(query, DocumentStatus::ACTUAL);
+        });
+        cerr << (query_evaluation == QueryEvaluation::EXHAUSTIVE ? "Exhaustive"s : "MaxScore"s) << ": status in predicate "s
+             << predicate_us << " us/query, status prefilter "s << prefilter_us << " us/query"s << endl;
+    }
+    search_server.SetQueryEvaluation(QueryEvaluation::EXHAUSTIVE);
+}
+
+
+void BenchmarkIdfCache() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 50'000, 12);
+    const auto documents = GenerateZipfTexts(generator, dictionary, 60'000, 50);
+    // Редкие слова: обработка вхождений дешёвая, и заметны расходы на каждое слово запроса
+    const vector<string> rare_words(dictionary.begin() + 5'000, dictionary.begin() + 7'000);
+    vector<string> queries;
+    for (int i = 0; i < 20'000; ++i) {
+        queries.push_back(GenerateQuery(generator, rare_words, 8));
+    }
+    SearchServer search_server(""s);
+    for (int i = 0; i < 50'000; ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1});
+    }
+
+    // writes_per_query_batch документов добавляется перед каждыми 100 запросами
+    int next_document_id = 50'000;
+    const auto run_queries = [&](const string& title, int writes_per_query_batch) {
+        size_t idf_computed = 0;
+        double query_seconds = 0.0;
+        for (size_t i = 0; i < queries.size(); ++i) {
+            if (i % 100 == 0) {
+                for (int j = 0; j < writes_per_query_batch && next_document_id < static_cast<int>(documents.size()); ++j, ++next_document_id) {
+                    search_server.AddDocument(next_document_id, documents[next_document_id], DocumentStatus::ACTUAL, {1});
+                }
+            }
+            const auto start = chrono::steady_clock::now();
+            search_server.FindTopDocuments(queries[i]);
+            query_seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            idf_computed += SearchServer::GetLastQueryStats().idf_computed;
+        }
+        cerr << title << ": "s << query_seconds * 1e6 / queries.size() << " us/query, "s
+             << idf_computed * 1.0 / queries.size() << " IDF computed per query"s << endl;
+    };
+    run_queries("Cold cache"s, 0);
+    run_queries("Warm cache, no writes"s, 0);
+    run_queries("Exact IDF, 1 write per 100 queries"s, 1);
+    search_server.SetIdfMaxDrift(0.01);
+    run_queries("Drift 1%, 1 write per 100 queries"s, 1);
+}
+
+
+void BenchmarkQueryResultCache() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 50'000, 12);
+    const auto documents = GenerateZipfTexts(generator, dictionary, 50'000, 50);
+    const auto distinct_queries = GenerateZipfTexts(generator, dictionary, 10'000, 3);
+    // Первый 1% различных запросов даёт 40% потока
+    vector<const string*> stream;
+    for (int i = 0; i < 100'000; ++i) {
+        const bool is_popular = uniform_real_distribution<>(0, 1)(generator) < 0.4;
+        const size_t index = uniform_int_distribution<size_t>(0, is_popular ? distinct_queries.size() / 100 - 1 : distinct_queries.size() - 1)(generator);
+        stream.push_back(&distinct_queries[index]);
+    }
+    SearchServer search_server(""s);
+    for (int i = 0; i < 40'000; ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1});
+    }
+
+    {
+        const auto start = chrono::steady_clock::now();
+        for (const string* query : stream) {
+            search_server.FindTopDocuments(*query);
+        }
+        cerr << "Without cache: "s << chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / stream.size()
+             << " us/query"s << endl;
+    }
+    // write_interval - через сколько запросов добавляется документ, 0 - без записи
+    int next_document_id = 40'000;
+    for (const size_t capacity : {1'000, 10'000}) {
+        for (const size_t write_interval : {0, 1'000, 100}) {
+            QueryResultCache cache(search_server, capacity);
+            const auto start = chrono::steady_clock::now();
+            for (size_t i = 0; i < stream.size(); ++i) {
+                if (write_interval > 0 && i % write_interval == 0 && next_document_id < static_cast<int>(documents.size())) {
+                    search_server.AddDocument(next_document_id, documents[next_document_id], DocumentStatus::ACTUAL, {1});
+                    ++next_document_id;
+                }
+                cache.FindTopDocuments(*stream[i]);
+            }
+            const double total_us = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+            const auto stats = cache.GetStats();
+            cerr << "Cache "s << capacity << ", write every "s << write_interval << " queries: "s << total_us / stream.size()
+                 << " us/query, hit rate "s << stats.GetHitRate() * 100 << "%, hit "s << stats.hit_latency_us << " us, miss "s
+                 << stats.miss_latency_us << " us, stale "s << stats.stale_count << endl;
+        }
+    }
+}
+
+
+// Прежний RemoveDuplicates: множество копий множеств слов всех документов
+static vector<int> FindDuplicatesByWordSets(const SearchServer& search_server) {
+    set<set<string>> originals_content;
+    vector<int> duplicate_ids;
+    for (const int document_id : search_server) {
+        set<string> content;
+        for (const auto& [word, freq] : search_server.GetWordFrequencies(document_id)) {
+            content.emplace(word);
+        }
+        if (!originals_content.emplace(move(content)).second) {
+            duplicate_ids.push_back(document_id);
+        }
+    }
+    return duplicate_ids;
+}
+
+void BenchmarkDuplicateDetector() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 50'000, 12);
+    auto documents = GenerateZipfTexts(generator, dictionary, 100'000, 50);
+    // Каждый десятый документ - копия одного из предыдущих с переставленными словами,
+    // ещё каждый десятый - копия с одним заменённым словом
+    for (size_t i = 1; i < documents.size(); ++i) {
+        if (i % 10 != 3 && i % 10 != 7) {
+            continue;
+        }
+        vector<string_view> words = SplitIntoWords(documents[uniform_int_distribution<size_t>(0, i - 1)(generator)]);
+        shuffle(words.begin(), words.end(), generator);
+        if (i % 10 == 7) {
+            words[0] = dictionary[uniform_int_distribution<size_t>(0, dictionary.size() - 1)(generator)];
+        }
+        string text;
+        for (const string_view word : words) {
+            text.append(word).push_back(' ');
+        }
+        documents[i] = move(text);
+    }
+    SearchServer search_server(""s);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1});
+    }
+
+    const auto measure = [&](const string& title, const auto& find_duplicates) {
+        const auto start = chrono::steady_clock::now();
+        const vector<int> duplicate_ids = find_duplicates();
+        cerr << title << ": "s << chrono::duration<double, milli>(chrono::steady_clock::now() - start).count()
+             << " ms, duplicates "s << duplicate_ids.size() << endl;
+    };
+    measure("Word sets"s, [&] { return FindDuplicatesByWordSets(search_server); });
+    measure("Fingerprints"s, [&] { return DuplicateDetector().FindDuplicates(search_server); });
+    measure("MinHash 0.9"s, [&] { return DuplicateDetector(0.9).FindDuplicates(search_server); });
+    measure("MinHash 0.8"s, [&] { return DuplicateDetector(0.8).FindDuplicates(search_server); });
+    {
+        LOG_DURATION("RemoveDuplicates"s);
+        const vector<int> duplicate_ids = DuplicateDetector().FindDuplicates(search_server);
+        search_server.RemoveDocuments(duplicate_ids);
+    }
+    cerr << "Documents left: "s << search_server.GetDocumentCount() << endl;
+}
+
+
+void BenchmarkDuplicatePolicy() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 50'000, 12);
+    auto documents = GenerateZipfTexts(generator, dictionary, 50'000, 50);
+    // Каждый пятый документ повторяет один из предыдущих
+    for (size_t i = 5; i < documents.size(); i += 5) {
+        documents[i] = documents[uniform_int_distribution<size_t>(0, i - 1)(generator)];
+    }
+    const vector<pair<string, DuplicatePolicy>> duplicate_policies = {
+        {"ALLOW"s, DuplicatePolicy::ALLOW}, {"REPORT"s, DuplicatePolicy::REPORT}, {"REJECT"s, DuplicatePolicy::REJECT}};
+    for (const auto& [name, duplicate_policy] : duplicate_policies) {
+        SearchServer search_server(""s);
+        search_server.SetDuplicatePolicy(duplicate_policy);
+        int rejected_count = 0;
+        const auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < documents.size(); ++i) {
+            try {
+                search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1});
+            } catch (const invalid_argument&) {
+                ++rejected_count;
+            }
+        }
+        cerr << name << ": "s
+             << chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / documents.size()
+             << " us/AddDocument, rejected "s << rejected_count << endl;
+    }
+}
+
+
+// Прежний RequestQueue: копии запросов и результатов в deque под общим мьютексом
+class LockedRequestQueue {
+public:
+    explicit LockedRequestQueue(const SearchServer& search_server)
+        : search_server_(search_server) {
+    }
+
+    vector<Document> AddFindRequest(const string& raw_query) {
+        vector<Document> result = search_server_.FindTopDocuments(raw_query);
+        lock_guard guard(mutex_);
+        requests_.push_back({raw_query, result, result.empty()});
+        if (requests_.size() > 1440) {
+            requests_.pop_front();
+        }
+        return result;
+    }
+    int GetNoResultRequests() const {
+        lock_guard guard(mutex_);
+        return count_if(requests_.begin(), requests_.end(), [](const auto& request) {
+            return get<2>(request);
+        });
+    }
+
+private:
+    const SearchServer& search_server_;
+    mutable mutex mutex_;
+    deque<tuple<string, vector<Document>, bool>> requests_;
+};
+
+template <typename Queue>
+static double MeasureRequestQueue(Queue& request_queue, int thread_count, const vector<string>& queries) {
+    const auto start = chrono::steady_clock::now();
+    vector<thread> threads;
+    atomic<int> no_result_sum = 0;
+    for (int t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&, t] {
+            for (size_t i = t; i < queries.size(); i += thread_count) {
+                request_queue.AddFindRequest(queries[i]);
+                no_result_sum += request_queue.GetNoResultRequests();
+            }
+        });
+    }
+    for (thread& worker : threads) {
+        worker.join();
+    }
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / queries.size();
+}
+
+void BenchmarkRequestQueue() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 10'000, 12);
+    const auto documents = GenerateZipfTexts(generator, dictionary, 2'000, 20);
+    const auto queries = GenerateQueries(generator, dictionary, 100'000, 3);
+    SearchServer search_server(""s);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1});
+    }
+    for (const int thread_count : {1, 4}) {
+        LockedRequestQueue locked_queue(search_server);
+        RequestQueue request_queue(search_server);
+        cerr << thread_count << " threads: deque + mutex "s << MeasureRequestQueue(locked_queue, thread_count, queries)
+             << " us/request, ring buffer "s << MeasureRequestQueue(request_queue, thread_count, queries) << " us/request, p50 "s
+             << request_queue.GetLatencyPercentile(0.5) << " us, p99 "s << request_queue.GetLatencyPercentile(0.99) << " us"s << endl;
+    }
+}
+
+
+void BenchmarkMetrics() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 20'000, 12);
+    const auto documents = GenerateZipfTexts(generator, dictionary, 20'000, 50);
+    const auto queries = GenerateQueries(generator, dictionary, 20'000, 5);
+    for (const bool is_enabled : {false, true}) {
+        Metrics::SetEnabled(is_enabled);
+        Metrics::Reset();
+        SearchServer search_server(""s);
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < documents.size(); ++i) {
+            search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1});
+        }
+        const double add_us = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / documents.size();
+        start = chrono::steady_clock::now();
+        for (const string& query : queries) {
+            search_server.FindTopDocuments(query);
+        }
+        const double find_us = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / queries.size();
+        cerr << "Metrics "s << (is_enabled ? "enabled"s : "disabled"s) << ": AddDocument "s << add_us << " us, FindTopDocuments "s
+             << find_us << " us"s << endl;
+    }
+    Metrics::SetEnabled(false);
+    cerr << Metrics::GetSnapshot().ToText();
+}
+
+#ifdef RUN_BENCHMARKS
+// Долгая нагрузка: запросы чередуются с заменой старых документов новыми, индекс сохраняет размер.
+// Показывает число выделений памяти на операцию и рост потребления памяти со временем
+void BenchmarkAllocations() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 20'000, 12);
+    const auto documents = GenerateZipfTexts(generator, dictionary, 40'000, 40);
+    const auto queries = GenerateQueries(generator, dictionary, 1'000, 3);
+    const int index_size = 20'000;
+    const int replaced_per_round = 2'000;
+
+    SearchServer search_server(""s);
+    for (int i = 0; i < index_size; ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+    int oldest_id = 0;
+    for (int round = 0; round < 10; ++round) {
+        size_t allocations_before = GetAllocationCount();
+        const auto start = chrono::steady_clock::now();
+        for (const string& query : queries) {
+            search_server.FindTopDocuments(query);
+        }
+        const double query_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        const size_t query_allocations = GetAllocationCount() - allocations_before;
+        allocations_before = GetAllocationCount();
+        for (int i = 0; i < replaced_per_round; ++i, ++oldest_id) {
+            search_server.RemoveDocument(oldest_id);
+            const int document_id = oldest_id + index_size;
+            search_server.AddDocument(document_id, documents[document_id % documents.size()], DocumentStatus::ACTUAL, {1, 2, 3});
+        }
+        const size_t update_allocations = GetAllocationCount() - allocations_before;
+        cerr << "Round "s << round << ": "s << query_allocations * 1.0 / queries.size() << " allocations per query ("s
+             << query_ms << " ms for "s << queries.size() << "), "s << update_allocations * 1.0 / replaced_per_round
+             << " per remove+add, RSS "s << GetResidentMemoryKb() << " KB"s << endl;
+    }
+}
+#else
+void BenchmarkAllocations() {
+}
+#endif
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <random>
+#include <string>
+#include <vector>
+
+//#define RUN_BENCHMARKS
+
+std::string GenerateWord(std::mt19937& generator, int max_length);
+std::vector<std::string> GenerateDictionary(std::mt19937& generator, int word_count, int max_length);
+std::string GenerateQuery(std::mt19937& generator, const std::vector<std::string>& dictionary, int word_count, double minus_prob = 0);
+std::vector<std::string> GenerateQueries(std::mt19937& generator, const std::vector<std::string>& dictionary, int query_count, int max_word_count);
+// Слова выбираются по закону Ципфа: вероятность слова с рангом r пропорциональна 1 / r^exponent
+std::vector<std::string> GenerateZipfTexts(std::mt19937& generator, const std::vector<std::string>& dictionary, int text_count,
+                                           int word_count, double exponent = 1.0);
+
+size_t GetResidentMemoryKb();
+
+void BenchmarkProcessQueries();
+void BenchmarkIndexBuild();
+void BenchmarkRemoveDocuments();
+void BenchmarkMaxScore();
+void BenchmarkSplitIntoWords();
+void BenchmarkShardedSearchServer();
+void BenchmarkSnapshotSearchServer();
+void BenchmarkMappedSearchServer();
+void BenchmarkBulkLoader();
+void BenchmarkRelevanceAccumulator();
+void BenchmarkStatusFilter();
+void BenchmarkIdfCache();
+void BenchmarkQueryResultCache();
+void BenchmarkDuplicateDetector();
+void BenchmarkDuplicatePolicy();
+void BenchmarkRequestQueue();
+void BenchmarkMetrics();
+void BenchmarkAllocations();
+
+inline void RunBenchmarks() {
+    BenchmarkProcessQueries();
+    BenchmarkIndexBuild();
+    BenchmarkRemoveDocuments();
+    BenchmarkMaxScore();
+    BenchmarkSplitIntoWords();
+    BenchmarkShardedSearchServer();
+    BenchmarkSnapshotSearchServer();
+    BenchmarkMappedSearchServer();
+    BenchmarkBulkLoader();
+    BenchmarkRelevanceAccumulator();
+    BenchmarkStatusFilter();
+    BenchmarkIdfCache();
+    BenchmarkQueryResultCache();
+    BenchmarkDuplicateDetector();
+    BenchmarkDuplicatePolicy();
+    BenchmarkRequestQueue();
+    BenchmarkMetrics();
+    BenchmarkAllocations();
+}
@@ -0,0 +1,73 @@
+#include "boundary_scan.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+static bool IsBoundary(char c) {
+    return static_cast<unsigned char>(c) <= static_cast<unsigned char>(' ');
+}
+
+static void ScanTail(const char* text, size_t from, size_t size, uint64_t* bitmap) {
+    for (size_t i = from; i < size; ++i) {
+        if (IsBoundary(text[i])) {
+            bitmap[i / 64] |= uint64_t{1} << (i % 64);
+        }
+    }
+}
+
+void ScanBoundariesScalar(const char* text, size_t size, uint64_t* bitmap) {
+    memset(bitmap, 0, (size + 63) / 64 * sizeof(uint64_t));
+    ScanTail(text, 0, size, bitmap);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// Беззнаковое x <= ' ' проверяется одной парой инструкций: min(x, ' ') == x
+__attribute__((target("sse2")))
+void ScanBoundariesSse2(const char* text, size_t size, uint64_t* bitmap) {
+    memset(bitmap, 0, (size + 63) / 64 * sizeof(uint64_t));
+    const __m128i space = _mm_set1_epi8(' ');
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+        const uint64_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(block, space), block)));
+        bitmap[i / 64] |= mask << (i % 64);
+    }
+    ScanTail(text, i, size, bitmap);
+}
+
+__attribute__((target("avx2")))
+void ScanBoundariesAvx2(const char* text, size_t size, uint64_t* bitmap) {
+    memset(bitmap, 0, (size + 63) / 64 * sizeof(uint64_t));
+    const __m256i space = _mm256_set1_epi8(' ');
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+        const uint64_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(block, space), block)));
+        bitmap[i / 64] |= mask << (i % 64);
+    }
+    ScanTail(text, i, size, bitmap);
+}
+#endif
+
+static BoundaryScanner SelectBoundaryScanner() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return ScanBoundariesAvx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return ScanBoundariesSse2;
+    }
+#endif
+    return ScanBoundariesScalar;
+}
+
+BoundaryScanner GetBoundaryScanner() {
+    static const BoundaryScanner scanner = SelectBoundaryScanner();
+    return scanner;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Поиск границ слов: для каждого байта text[i] <= ' ' (пробел или управляющий символ)
+// выставляется бит i в bitmap. bitmap должен вмещать (size + 63) / 64 слов.
+using BoundaryScanner = void (*)(const char* text, size_t size, uint64_t* bitmap);
+
+void ScanBoundariesScalar(const char* text, size_t size, uint64_t* bitmap);
+#if defined(__x86_64__) || defined(__i386__)
+void ScanBoundariesSse2(const char* text, size_t size, uint64_t* bitmap);
+void ScanBoundariesAvx2(const char* text, size_t size, uint64_t* bitmap);
+#endif
+
+// Лучшая реализация для текущего процессора, выбирается один раз при первом вызове
+BoundaryScanner GetBoundaryScanner();
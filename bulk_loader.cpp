@@ -0,0 +1,189 @@
+#include "bulk_loader.h"
+#include "bounded_queue.h"
+
+#include <atomic>
+#include <charconv>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+
+using namespace std;
+
+static const string_view STATUS_NAMES[] = {"ACTUAL"sv, "IRRELEVANT"sv, "BANNED"sv, "REMOVED"sv};
+
+static int ParseNumber(string_view text) {
+    int number = 0;
+    const auto [end, error] = from_chars(text.data(), text.data() + text.size(), number);
+    if (error != errc{} || end != text.data() + text.size()) {
+        throw invalid_argument("invalid number in document line: "s + string(text));
+    }
+    return number;
+}
+
+static string_view CutField(string_view& line) {
+    const size_t tab = line.find('\t');
+    if (tab == string_view::npos) {
+        throw invalid_argument("invalid document line: "s + string(line));
+    }
+    const string_view field = line.substr(0, tab);
+    line.remove_prefix(tab + 1);
+    return field;
+}
+
+static DocumentStatus ParseStatus(string_view text) {
+    for (size_t i = 0; i < size(STATUS_NAMES); ++i) {
+        if (STATUS_NAMES[i] == text) {
+            return static_cast<DocumentStatus>(i);
+        }
+    }
+    throw invalid_argument("invalid document status: "s + string(text));
+}
+
+static size_t AddDocumentLines(SearchServer& search_server, string_view chunk) {
+    size_t document_count = 0;
+    vector<int> ratings;
+    while (!chunk.empty()) {
+        const size_t line_end = chunk.find('\n');
+        string_view line = chunk.substr(0, line_end);
+        chunk.remove_prefix(line_end == string_view::npos ? chunk.size() : line_end + 1);
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if (line.empty()) {
+            continue;
+        }
+        const int document_id = ParseNumber(CutField(line));
+        const DocumentStatus status = ParseStatus(CutField(line));
+        ratings.clear();
+        for (const string_view rating : SplitIntoWords(CutField(line))) {
+            if (!rating.empty()) {
+                ratings.push_back(ParseNumber(rating));
+            }
+        }
+        search_server.AddDocument(document_id, line, status, ratings);
+        ++document_count;
+    }
+    return document_count;
+}
+
+BulkLoadStats LoadDocuments(SearchServer& search_server, istream& input, const BulkLoadOptions& options) {
+    const auto start = chrono::steady_clock::now();
+    const size_t worker_count = max(options.worker_count, size_t{1});
+    const size_t chunk_size = max(options.chunk_size, size_t{1});
+    BoundedQueue<string> chunks(max(options.max_queued_chunks, size_t{1}));
+    atomic<size_t> document_count = 0;
+    mutex error_mutex;
+    exception_ptr error;
+    const auto fail = [&](exception_ptr worker_error) {
+        {
+            lock_guard guard(error_mutex);
+            if (!error) {
+                error = worker_error;
+            }
+        }
+        chunks.Close();
+    };
+
+    vector<unique_ptr<SearchServer>> partial_servers;
+    vector<thread> workers;
+    BulkLoadStats stats;
+    auto last_report = start;
+    string carry;
+    // При любой ошибке запуска или чтения рабочие потоки останавливаются и завершаются,
+    // иначе деструктор thread вызовет terminate
+    try {
+        for (size_t i = 0; i < worker_count; ++i) {
+            partial_servers.push_back(make_unique<SearchServer>(search_server.GetStopWords()));
+            workers.emplace_back([&, &partial_server = *partial_servers.back()] {
+                try {
+                    while (const optional<string> chunk = chunks.Pop()) {
+                        document_count += AddDocumentLines(partial_server, *chunk);
+                    }
+                } catch (...) {
+                    fail(current_exception());
+                }
+            });
+        }
+        while (input) {
+            string chunk = move(carry);
+            const size_t carry_size = chunk.size();
+            chunk.resize(carry_size + chunk_size);
+            input.read(chunk.data() + carry_size, chunk_size);
+            chunk.resize(carry_size + input.gcount());
+            stats.byte_count += input.gcount();
+            if (!input) {
+                if (!chunk.empty()) {
+                    chunks.Push(move(chunk));
+                }
+                break;
+            }
+            // Неполная последняя строка переносится в следующий блок
+            const size_t last_line_end = chunk.rfind('\n');
+            if (last_line_end == string::npos) {
+                carry = move(chunk);
+                continue;
+            }
+            carry = chunk.substr(last_line_end + 1);
+            chunk.resize(last_line_end + 1);
+            if (!chunks.Push(move(chunk))) {
+                break;
+            }
+            const auto now = chrono::steady_clock::now();
+            if (options.progress_output != nullptr && now - last_report >= options.progress_interval) {
+                const double seconds = chrono::duration<double>(now - start).count();
+                *options.progress_output << "Loaded "s << document_count << " documents, "s
+                                         << static_cast<size_t>(document_count / seconds) << " docs/s"s << endl;
+                last_report = now;
+            }
+        }
+        // Конец потока выставляет только eof и fail, badbit означает ошибку чтения
+        if (input.bad()) {
+            throw ios_base::failure("error reading document stream"s);
+        }
+    } catch (...) {
+        chunks.Close();
+        for (thread& worker : workers) {
+            worker.join();
+        }
+        throw;
+    }
+    chunks.Close();
+    for (thread& worker : workers) {
+        worker.join();
+    }
+    if (error) {
+        rethrow_exception(error);
+    }
+
+    vector<const SearchServer*> sources;
+    for (const auto& partial_server : partial_servers) {
+        sources.push_back(partial_server.get());
+    }
+    search_server.MergeDocuments(sources);
+    stats.document_count = document_count;
+    stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (options.progress_output != nullptr) {
+        *options.progress_output << "Loaded "s << stats.document_count << " documents in "s << stats.seconds << " s, "s
+                                 << static_cast<size_t>(stats.document_count / stats.seconds) << " docs/s"s << endl;
+    }
+    return stats;
+}
+
+BulkLoadStats LoadDocuments(SearchServer& search_server, const string& path, const BulkLoadOptions& options) {
+    ifstream input(path, ios::binary);
+    if (!input) {
+        throw invalid_argument("cannot open input file "s + path);
+    }
+    return LoadDocuments(search_server, input, options);
+}
+
+void WriteDocumentLine(ostream& output, int document_id, DocumentStatus status, const vector<int>& ratings, string_view document) {
+    output << document_id << '\t' << STATUS_NAMES[static_cast<int>(status)] << '\t';
+    bool is_first = true;
+    for (const int rating : ratings) {
+        output << (is_first ? ""sv : " "sv) << rating;
+        is_first = false;
+    }
+    output << '\t' << document << '\n';
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "search_server.h"
+
+#include <algorithm>
+#include <chrono>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// Формат входных данных: одна строка на документ, поля разделены табуляцией:
+// id, статус (ACTUAL, IRRELEVANT, BANNED, REMOVED), оценки через пробел, текст документа.
+// Пустые строки пропускаются.
+struct BulkLoadOptions {
+    size_t worker_count = std::max(1u, std::thread::hardware_concurrency());
+    // Вход читается блоками примерно такого размера, каждый блок заканчивается целой строкой.
+    // Нулевые размеры и количества считаются равными 1
+    size_t chunk_size = 1 << 20;
+    // Сколько прочитанных блоков может ждать обработки, прежде чем чтение приостановится
+    size_t max_queued_chunks = 16;
+    std::ostream* progress_output = nullptr;
+    std::chrono::milliseconds progress_interval{1000};
+};
+
+struct BulkLoadStats {
+    size_t document_count = 0;
+    size_t byte_count = 0;
+    double seconds = 0.0;
+};
+
+// Конвейер загрузки: поток чтения режет вход на блоки и кладёт их в ограниченную очередь,
+// рабочие потоки разбирают строки и строят собственные частичные индексы, которые
+// затем за один шаг сливаются в search_server. При ошибке в любой строке или ошибке чтения индекс не меняется,
+// а исключение пробрасывается вызывающему. Политика дубликатов search_server соблюдается
+// при слиянии (см. MergeDocuments); document_count - число разобранных строк.
+BulkLoadStats LoadDocuments(SearchServer& search_server, std::istream& input, const BulkLoadOptions& options = {});
+BulkLoadStats LoadDocuments(SearchServer& search_server, const std::string& path, const BulkLoadOptions& options = {});
+
+// Запись документа в формате загрузчика
+void WriteDocumentLine(std::ostream& output, int document_id, DocumentStatus status, const std::vector<int>& ratings,
+                       std::string_view document);
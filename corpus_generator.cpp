@@ -0,0 +1,165 @@
+#include "corpus_generator.h"
+#include "fingerprint.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_set>
+
+using namespace std;
+
+// Независимые последовательности для словаря, документов и запросов
+static const uint64_t VOCABULARY_STREAM = 1;
+static const uint64_t DOCUMENT_STREAM = 2;
+static const uint64_t QUERY_STREAM = 3;
+
+static uint64_t MakeSeed(uint64_t seed, uint64_t stream, uint64_t index) {
+    return MixHash(MixHash(seed ^ MixHash(stream)) + index);
+}
+
+CorpusGenerator::Random::Random(uint64_t seed)
+    : state_(seed) {
+}
+
+uint64_t CorpusGenerator::Random::Next() {
+    state_ += 0x9e3779b97f4a7c15ull;
+    return MixHash(state_);
+}
+
+uint64_t CorpusGenerator::Random::NextBelow(uint64_t bound) {
+    return Next() % bound;
+}
+
+double CorpusGenerator::Random::NextDouble() {
+    return (Next() >> 11) * 0x1.0p-53;
+}
+
+CorpusGenerator::CorpusGenerator(const CorpusOptions& options)
+    : options_(options) {
+    if (options.vocabulary_size == 0) {
+        throw invalid_argument("vocabulary must not be empty"s);
+    }
+    if (options.min_document_length <= 0 || options.min_document_length > options.max_document_length) {
+        throw invalid_argument("invalid document length range"s);
+    }
+    if (options.stop_word_ratio < 0.0 || options.stop_word_ratio > 1.0 || options.duplicate_ratio < 0.0 || options.duplicate_ratio > 1.0) {
+        throw invalid_argument("ratios must be in [0, 1]"s);
+    }
+    if (options.stop_word_ratio > 0.0 && options.stop_word_count == 0) {
+        throw invalid_argument("stop word ratio without stop words"s);
+    }
+    if (any_of(options.status_weights.begin(), options.status_weights.end(), [](double weight) { return weight < 0.0; })
+        || accumulate(options.status_weights.begin(), options.status_weights.end(), 0.0) <= 0.0) {
+        throw invalid_argument("invalid status weights"s);
+    }
+
+    Random random(MakeSeed(options.seed, VOCABULARY_STREAM, 0));
+    unordered_set<string> words;
+    const auto generate_word = [&random, &words] {
+        while (true) {
+            string word(2 + random.NextBelow(9), ' ');
+            for (char& letter : word) {
+                letter = static_cast<char>('a' + random.NextBelow(26));
+            }
+            if (words.insert(word).second) {
+                return word;
+            }
+        }
+    };
+    while (stop_words_.size() < options.stop_word_count) {
+        stop_words_.push_back(generate_word());
+    }
+    vocabulary_.reserve(options.vocabulary_size);
+    cumulative_weights_.reserve(options.vocabulary_size);
+    double weight_sum = 0.0;
+    while (vocabulary_.size() < options.vocabulary_size) {
+        vocabulary_.push_back(generate_word());
+        weight_sum += 1.0 / pow(static_cast<double>(vocabulary_.size()), options.zipf_exponent);
+        cumulative_weights_.push_back(weight_sum);
+    }
+}
+
+const vector<string>& CorpusGenerator::GetVocabulary() const {
+    return vocabulary_;
+}
+
+string CorpusGenerator::GetStopWordsText() const {
+    string text;
+    for (const string& stop_word : stop_words_) {
+        if (!text.empty()) {
+            text.push_back(' ');
+        }
+        text += stop_word;
+    }
+    return text;
+}
+
+const string& CorpusGenerator::SampleWord(Random& random) const {
+    const double point = random.NextDouble() * cumulative_weights_.back();
+    const size_t rank = upper_bound(cumulative_weights_.begin(), cumulative_weights_.end(), point) - cumulative_weights_.begin();
+    return vocabulary_[min(rank, vocabulary_.size() - 1)];
+}
+
+// Дубликат берёт слова документа с меньшим id и переставляет их, поэтому множество слов совпадает
+vector<const string*> CorpusGenerator::GenerateWords(int document_id) const {
+    Random random(MakeSeed(options_.seed, DOCUMENT_STREAM, document_id));
+    if (document_id > 0 && random.NextDouble() < options_.duplicate_ratio) {
+        vector<const string*> words = GenerateWords(static_cast<int>(random.NextBelow(document_id)));
+        for (size_t i = words.size(); i > 1; --i) {
+            swap(words[i - 1], words[random.NextBelow(i)]);
+        }
+        return words;
+    }
+    const int length = options_.min_document_length + static_cast<int>(random.NextBelow(options_.max_document_length - options_.min_document_length + 1));
+    vector<const string*> words;
+    words.reserve(length);
+    for (int i = 0; i < length; ++i) {
+        if (random.NextDouble() < options_.stop_word_ratio) {
+            words.push_back(&stop_words_[random.NextBelow(stop_words_.size())]);
+        } else {
+            words.push_back(&SampleWord(random));
+        }
+    }
+    return words;
+}
+
+GeneratedDocument CorpusGenerator::GenerateDocument(int document_id) const {
+    GeneratedDocument document;
+    document.id = document_id;
+    for (const string* word : GenerateWords(document_id)) {
+        if (!document.text.empty()) {
+            document.text.push_back(' ');
+        }
+        document.text += *word;
+    }
+    // Статус и рейтинги берутся из отдельной последовательности, чтобы дубликаты их не копировали
+    Random random(MakeSeed(options_.seed, DOCUMENT_STREAM, ~static_cast<uint64_t>(document_id)));
+    double point = random.NextDouble() * accumulate(options_.status_weights.begin(), options_.status_weights.end(), 0.0);
+    int status = 0;
+    while (status < DOCUMENT_STATUS_COUNT - 1 && point >= options_.status_weights[status]) {
+        point -= options_.status_weights[status];
+        ++status;
+    }
+    document.status = static_cast<DocumentStatus>(status);
+    const int rating_count = 1 + static_cast<int>(random.NextBelow(5));
+    for (int i = 0; i < rating_count; ++i) {
+        document.ratings.push_back(static_cast<int>(random.NextBelow(21)) - 10);
+    }
+    return document;
+}
+
+string CorpusGenerator::GenerateQuery(uint64_t query_id, int plus_word_count, int minus_word_count) const {
+    Random random(MakeSeed(options_.seed, QUERY_STREAM, query_id));
+    string query;
+    for (int i = 0; i < plus_word_count + minus_word_count; ++i) {
+        if (!query.empty()) {
+            query.push_back(' ');
+        }
+        if (i >= plus_word_count) {
+            query.push_back('-');
+        }
+        query += SampleWord(random);
+    }
+    return query;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "document.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct CorpusOptions {
+    uint64_t seed = 42;
+    size_t vocabulary_size = 50'000;
+    // Частота слова с рангом r пропорциональна 1 / r^zipf_exponent
+    double zipf_exponent = 1.0;
+    int min_document_length = 20;
+    int max_document_length = 60;
+    size_t stop_word_count = 30;
+    // Доля стоп-слов среди слов документа
+    double stop_word_ratio = 0.2;
+    // Доля документов, повторяющих множество слов одного из предыдущих документов
+    double duplicate_ratio = 0.0;
+    // Веса статусов в порядке DocumentStatus
+    std::array<double, DOCUMENT_STATUS_COUNT> status_weights = {0.85, 0.05, 0.05, 0.05};
+};
+
+struct GeneratedDocument {
+    int id = 0;
+    std::string text;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    std::vector<int> ratings;
+};
+
+// Синтетическая коллекция с частотами слов по закону Ципфа. Всё определяется только
+// параметрами: словарь строится при создании, а документ с данным id - от своего зерна,
+// поэтому документы любого размера коллекции можно порождать потоком, по одному.
+// Генератор случайных чисел свой (splitmix64), и результат не зависит от стандартной библиотеки
+class CorpusGenerator {
+public:
+    explicit CorpusGenerator(const CorpusOptions& options = {});
+
+    const std::vector<std::string>& GetVocabulary() const;
+    // Стоп-слова через пробел, для конструктора SearchServer
+    std::string GetStopWordsText() const;
+    GeneratedDocument GenerateDocument(int document_id) const;
+    // Запрос с query_id-м зерном: plus_word_count плюс-слов и minus_word_count минус-слов
+    std::string GenerateQuery(uint64_t query_id, int plus_word_count, int minus_word_count) const;
+
+private:
+    class Random {
+    public:
+        explicit Random(uint64_t seed);
+        uint64_t Next();
+        // Число от 0 до bound - 1
+        uint64_t NextBelow(uint64_t bound);
+        double NextDouble();
+
+    private:
+        uint64_t state_;
+    };
+
+    const std::string& SampleWord(Random& random) const;
+    std::vector<const std::string*> GenerateWords(int document_id) const;
+
+    CorpusOptions options_;
+    std::vector<std::string> vocabulary_;
+    std::vector<std::string> stop_words_;
+    // Накопленные веса рангов словаря для выбора слова двоичным поиском
+    std::vector<double> cumulative_weights_;
+};
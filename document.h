@@ -9,6 +9,8 @@ enum class DocumentStatus {
     REMOVED
 };
 
+const int DOCUMENT_STATUS_COUNT = 4;
+
 std::ostream& operator<<(std::ostream& out, DocumentStatus status);
 
 struct Document {
@@ -0,0 +1,184 @@
+#include "duplicate_detector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <execution>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+using namespace std;
+
+using TermFreqs = pmr::vector<pair<TermId, float>>;
+
+// Доля пар с коэффициентом Жаккара, равным порогу, которую должен находить LSH
+static const double MIN_LSH_RECALL = 0.95;
+
+// Термины документа отсортированы по TermId
+static double ComputeJaccard(const TermFreqs& lhs, const TermFreqs& rhs) {
+    size_t common_count = 0;
+    auto lhs_it = lhs.begin();
+    auto rhs_it = rhs.begin();
+    while (lhs_it != lhs.end() && rhs_it != rhs.end()) {
+        if (lhs_it->first < rhs_it->first) {
+            ++lhs_it;
+        } else if (rhs_it->first < lhs_it->first) {
+            ++rhs_it;
+        } else {
+            ++common_count;
+            ++lhs_it;
+            ++rhs_it;
+        }
+    }
+    const size_t union_count = lhs.size() + rhs.size() - common_count;
+    return union_count == 0 ? 1.0 : common_count * 1.0 / union_count;
+}
+
+// Вероятность, что LSH сведёт в одну корзину документы с коэффициентом Жаккара jaccard
+static double ComputeLshRecall(double jaccard, size_t band_count, size_t rows_per_band) {
+    return 1.0 - pow(1.0 - pow(jaccard, rows_per_band), band_count);
+}
+
+DuplicateDetector::DuplicateDetector(double min_jaccard, size_t hash_count)
+    : min_jaccard_(min_jaccard) {
+    if (!(min_jaccard > 0.0 && min_jaccard <= 1.0)) {
+        throw invalid_argument("Jaccard threshold must be in (0, 1]"s);
+    }
+    if (hash_count == 0) {
+        throw invalid_argument("MinHash signature must not be empty"s);
+    }
+    // Чем длиннее полоса, тем меньше случайных кандидатов, поэтому берётся самая длинная
+    // полоса, при которой пары на пороге ещё находятся с нужной вероятностью
+    rows_per_band_ = 1;
+    for (size_t rows_per_band = hash_count; rows_per_band > 1; --rows_per_band) {
+        if (ComputeLshRecall(min_jaccard, hash_count / rows_per_band, rows_per_band) >= MIN_LSH_RECALL) {
+            rows_per_band_ = rows_per_band;
+            break;
+        }
+    }
+    band_count_ = hash_count / rows_per_band_;
+    for (size_t i = 0; i < band_count_ * rows_per_band_; ++i) {
+        hash_seeds_.push_back(MixHash(i + 1));
+    }
+}
+
+vector<int> DuplicateDetector::FindDuplicates(const SearchServer& search_server) const {
+    if (min_jaccard_ >= 1.0) {
+        return FindExactDuplicates(search_server);
+    }
+    return FindNearDuplicates(search_server);
+}
+
+// Термины документов по возрастанию id
+vector<const TermFreqs*> DuplicateDetector::CollectDocuments(const SearchServer& search_server) {
+    vector<const TermFreqs*> documents;
+    documents.reserve(search_server.document_to_ordinal_.size());
+    for (const auto& [document_id, ordinal] : search_server.document_to_ordinal_) {
+        documents.push_back(&search_server.document_term_freqs_[ordinal]);
+    }
+    return documents;
+}
+
+vector<int> DuplicateDetector::FindExactDuplicates(const SearchServer& search_server) const {
+    const vector<const TermFreqs*> documents = CollectDocuments(search_server);
+    vector<Fingerprint> fingerprints(documents.size());
+    transform(execution::par, documents.begin(), documents.end(), fingerprints.begin(),
+              [](const TermFreqs* term_freqs) {
+                  return SearchServer::ComputeFingerprint(*term_freqs);
+              });
+
+    vector<int> duplicate_ids;
+    unordered_map<Fingerprint, const TermFreqs*, FingerprintHasher> originals;
+    originals.reserve(documents.size());
+    size_t index = 0;
+    for (const auto& [document_id, ordinal] : search_server.document_to_ordinal_) {
+        const auto [original_it, is_inserted] = originals.emplace(fingerprints[index], documents[index]);
+        // Совпадение отпечатков у разных множеств практически исключено, но проверить его дёшево
+        if (!is_inserted && SearchServer::HaveSameTerms(*original_it->second, *documents[index])) {
+            duplicate_ids.push_back(document_id);
+        }
+        ++index;
+    }
+    return duplicate_ids;
+}
+
+// Подписи целиком не хранятся: ключи полосы считаются параллельно по одной полосе за раз,
+// а корзины полосы строятся сортировкой пар (ключ, номер документа). От полосы остаётся только
+// ссылка каждого документа на предыдущий документ той же корзины, 4 байта на документ
+vector<int> DuplicateDetector::FindNearDuplicates(const SearchServer& search_server) const {
+    const vector<const TermFreqs*> documents = CollectDocuments(search_server);
+    const uint32_t no_document = numeric_limits<uint32_t>::max();
+    vector<vector<uint32_t>> previous_in_bucket(band_count_);
+    vector<pair<uint64_t, uint32_t>> band_entries(documents.size());
+    for (size_t band = 0; band < band_count_; ++band) {
+        transform(execution::par, documents.begin(), documents.end(), band_entries.begin(),
+                  [this, band, &documents](const TermFreqs* const& term_freqs) {
+                      return pair{ComputeBandKey(*term_freqs, band), static_cast<uint32_t>(&term_freqs - documents.data())};
+                  });
+        sort(execution::par, band_entries.begin(), band_entries.end());
+        vector<uint32_t>& previous = previous_in_bucket[band];
+        previous.assign(documents.size(), no_document);
+        for (size_t i = 1; i < band_entries.size(); ++i) {
+            if (band_entries[i].first == band_entries[i - 1].first) {
+                previous[band_entries[i].second] = band_entries[i - 1].second;
+            }
+        }
+    }
+    band_entries = {};
+
+    vector<int> duplicate_ids;
+    vector<bool> is_duplicate(documents.size());
+    // Ближайший предыдущий оставленный документ корзины. Найденные дубликаты вычёркиваются из
+    // цепочки по пути, поэтому каждый дубликат пропускается в полосе не больше одного раза
+    const auto previous_kept = [&is_duplicate, no_document](vector<uint32_t>& previous, uint32_t index) {
+        while (previous[index] != no_document && is_duplicate[previous[index]]) {
+            previous[index] = previous[previous[index]];
+        }
+        return previous[index];
+    };
+    // Номер документа, для которого кандидат уже проверялся, чтобы не сравнивать дважды
+    vector<uint32_t> checked_for(documents.size(), no_document);
+    uint32_t index = 0;
+    for (const auto& [document_id, ordinal] : search_server.document_to_ordinal_) {
+        for (size_t band = 0; band < band_count_ && !is_duplicate[index]; ++band) {
+            vector<uint32_t>& previous = previous_in_bucket[band];
+            for (uint32_t candidate = previous_kept(previous, index); candidate != no_document;
+                 candidate = previous_kept(previous, candidate)) {
+                if (checked_for[candidate] == index) {
+                    continue;
+                }
+                checked_for[candidate] = index;
+                if (ComputeJaccard(*documents[candidate], *documents[index]) >= min_jaccard_ - EPSILON) {
+                    is_duplicate[index] = true;
+                    break;
+                }
+            }
+        }
+        if (is_duplicate[index]) {
+            duplicate_ids.push_back(document_id);
+        }
+        ++index;
+    }
+    return duplicate_ids;
+}
+
+// Ключ полосы - свёртка её строк MinHash-подписи: i-я строка - минимум i-й хеш-функции по терминам документа
+uint64_t DuplicateDetector::ComputeBandKey(const SearchServer::TermFreqs& term_freqs, size_t band) const {
+    static thread_local vector<uint64_t> minimums;
+    minimums.assign(rows_per_band_, numeric_limits<uint64_t>::max());
+    const uint64_t* seeds = hash_seeds_.data() + band * rows_per_band_;
+    for (const auto& [term_id, term_freq] : term_freqs) {
+        const uint64_t term_hash = MixHash(term_id);
+        for (size_t row = 0; row < rows_per_band_; ++row) {
+            uint64_t value = (term_hash ^ seeds[row]) * 0xbf58476d1ce4e5b9ull;
+            value ^= value >> 32;
+            minimums[row] = min(minimums[row], value);
+        }
+    }
+    uint64_t band_key = band;
+    for (const uint64_t minimum : minimums) {
+        band_key = MixHash(band_key ^ minimum);
+    }
+    return band_key;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "search_server.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Поиск дубликатов по множествам слов документов (стоп-слова и повторы слов не учитываются).
+// Документы просматриваются по возрастанию id, дубликатом считается документ, похожий на
+// один из оставленных документов с меньшим id.
+//
+// Точный режим: множество слов сворачивается в 128-битный отпечаток суммами хешей терминов,
+// не зависящими от порядка слов, и каждый документ проверяется одним обращением к хеш-таблице.
+// Совпадение отпечатков подтверждается сравнением множеств.
+//
+// Режим близких дубликатов: MinHash-подписи и LSH по полосам подписи. Кандидаты из общих
+// корзин проверяются точным коэффициентом Жаккара, поэтому ложных срабатываний нет, а пара
+// с коэффициентом, равным порогу, находится с вероятностью не ниже 95%.
+//
+// Отпечатки и ключи полос считаются параллельно. Подписи не хранятся: на документ
+// приходится 4 байта на полосу и несколько байт служебных массивов.
+class DuplicateDetector {
+public:
+    // Точный режим
+    DuplicateDetector() = default;
+    // min_jaccard в (0, 1], при 1 - точный режим. hash_count - длина MinHash-подписи
+    explicit DuplicateDetector(double min_jaccard, size_t hash_count = 128);
+
+    // id дубликатов по возрастанию
+    std::vector<int> FindDuplicates(const SearchServer& search_server) const;
+
+    size_t GetBandCount() const {
+        return band_count_;
+    }
+    size_t GetRowsPerBand() const {
+        return rows_per_band_;
+    }
+
+private:
+    static std::vector<const SearchServer::TermFreqs*> CollectDocuments(const SearchServer& search_server);
+    std::vector<int> FindExactDuplicates(const SearchServer& search_server) const;
+    std::vector<int> FindNearDuplicates(const SearchServer& search_server) const;
+    uint64_t ComputeBandKey(const SearchServer::TermFreqs& term_freqs, size_t band) const;
+
+    double min_jaccard_ = 1.0;
+    size_t band_count_ = 0;
+    size_t rows_per_band_ = 0;
+    std::vector<uint64_t> hash_seeds_;
+};
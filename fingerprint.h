@@ -0,0 +1,38 @@
+#pragma once
+
+#include "term_dictionary.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Финальное перемешивание splitmix64
+inline uint64_t MixHash(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ull;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebull;
+    value ^= value >> 31;
+    return value;
+}
+
+// 128-битный отпечаток множества терминов. Половины - суммы разных хешей терминов,
+// поэтому отпечаток не зависит от порядка добавления. Каждый термин добавляется один раз
+struct Fingerprint {
+    uint64_t low = 0;
+    uint64_t high = 0;
+
+    void Add(TermId term_id) {
+        low += MixHash(term_id);
+        high += MixHash(term_id ^ 0x5bd1e9955bd1e995ull) + 1;
+    }
+
+    bool operator==(const Fingerprint& other) const {
+        return low == other.low && high == other.high;
+    }
+};
+
+struct FingerprintHasher {
+    size_t operator()(const Fingerprint& fingerprint) const {
+        return fingerprint.low ^ (fingerprint.high * 0x9e3779b97f4a7c15ull);
+    }
+};
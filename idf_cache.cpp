@@ -0,0 +1,66 @@
+#include "idf_cache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+IdfCache::IdfCache(const IdfCache& other) {
+    *this = other;
+}
+
+// Значения копируются вместе с эпохами, поэтому вычисленные для текущей эпохи остаются годными
+IdfCache& IdfCache::operator=(const IdfCache& other) {
+    if (this != &other) {
+        entries_.clear();
+        Resize(other.entries_.size());
+        for (size_t i = 0; i < entries_.size(); ++i) {
+            entries_[i].inverse_document_freq.store(other.entries_[i].inverse_document_freq.load(memory_order_relaxed), memory_order_relaxed);
+            entries_[i].epoch.store(other.entries_[i].epoch.load(memory_order_relaxed), memory_order_relaxed);
+        }
+        epoch_ = other.epoch_;
+        document_count_ = other.document_count_;
+        epoch_document_count_ = other.epoch_document_count_;
+        max_drift_ = other.max_drift_;
+    }
+    return *this;
+}
+
+void IdfCache::Resize(size_t term_count) {
+    while (entries_.size() < term_count) {
+        entries_.emplace_back();
+    }
+}
+
+void IdfCache::SetDocumentCount(size_t document_count) {
+    document_count_ = document_count;
+    const double drift = abs(static_cast<double>(document_count) - static_cast<double>(epoch_document_count_));
+    if (drift > max_drift_ * epoch_document_count_) {
+        epoch_document_count_ = document_count;
+        ++epoch_;
+    }
+}
+
+void IdfCache::Invalidate(TermId term_id) {
+    entries_[term_id].epoch.store(0, memory_order_relaxed);
+}
+
+void IdfCache::SetMaxDrift(double max_drift) {
+    if (max_drift < 0.0 || max_drift >= 1.0) {
+        throw invalid_argument("IDF drift must be in [0, 1)"s);
+    }
+    max_drift_ = max_drift;
+    epoch_document_count_ = document_count_;
+    ++epoch_;
+}
+
+// Одновременно вычислять значение могут несколько читателей, но все они получают одно и то же.
+// Частота термина точна и может превысить зафиксированное число документов; тогда настоящее
+// число документов не меньше частоты, и IDF берётся равным 0, а не отрицательным
+double IdfCache::Compute(const Entry& entry, size_t document_freq) const {
+    const double inverse_document_freq = log(max(epoch_document_count_, document_freq) * 1.0 / document_freq);
+    entry.inverse_document_freq.store(inverse_document_freq, memory_order_relaxed);
+    entry.epoch.store(epoch_, memory_order_release);
+    return inverse_document_freq;
+}
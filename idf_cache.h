@@ -0,0 +1,56 @@
+#pragma once
+
+#include "term_dictionary.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+// Кэш IDF терминов, индексированный TermId. Значение вычисляется при первом обращении и
+// помечается эпохой; изменение числа документов начинает новую эпоху и разом делает
+// устаревшими все значения, изменение частоты термина сбрасывает только его значение.
+// Читать кэш можно из нескольких потоков одновременно, менять - только при отсутствии читателей.
+//
+// С допустимым дрейфом max_drift эпоха сменяется, лишь когда число документов отошло от
+// зафиксированного в начале эпохи больше чем на долю max_drift. IDF считается по зафиксированному
+// числу, поэтому ошибка не превышает |ln(1 - max_drift)|, а частоты терминов всегда точны.
+class IdfCache {
+public:
+    IdfCache() = default;
+    IdfCache(const IdfCache& other);
+    IdfCache(IdfCache&&) = default;
+    IdfCache& operator=(const IdfCache& other);
+    IdfCache& operator=(IdfCache&&) = default;
+
+    void Resize(size_t term_count);
+    void SetDocumentCount(size_t document_count);
+    void Invalidate(TermId term_id);
+    void SetMaxDrift(double max_drift);
+
+    // computed_count увеличивается, если значение пришлось вычислить
+    double Get(TermId term_id, size_t document_freq, size_t& computed_count) const {
+        const Entry& entry = entries_[term_id];
+        if (entry.epoch.load(std::memory_order_acquire) == epoch_) {
+            return entry.inverse_document_freq.load(std::memory_order_relaxed);
+        }
+        ++computed_count;
+        return Compute(entry, document_freq);
+    }
+
+private:
+    struct Entry {
+        mutable std::atomic<double> inverse_document_freq{0.0};
+        // Эпоха, для которой вычислено значение; 0 - значения нет
+        mutable std::atomic<uint64_t> epoch{0};
+    };
+
+    double Compute(const Entry& entry, size_t document_freq) const;
+
+    // deque не перемещает элементы при добавлении, а атомарные значения перемещать нельзя
+    std::deque<Entry> entries_;
+    uint64_t epoch_ = 1;
+    size_t document_count_ = 0;
+    size_t epoch_document_count_ = 0;
+    double max_drift_ = 0.0;
+};
@@ -1,3 +1,4 @@
+#include "benchmark_functions.h"
 #include "search_server.h"
 #include "request_queue.h"
 #include "test_example_functions.h"
@@ -9,6 +10,9 @@ using namespace std;
 
 int main() {
     TestSearchServer();
+#ifdef RUN_BENCHMARKS
+    RunBenchmarks();
+#endif
     SearchServer search_server("and with"s);
 
     AddDocument(search_server, 1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7, 2, 7});
@@ -0,0 +1,389 @@
+#include "mapped_search_server.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+// Секции записываются подряд, каждая начинается с границы 8 байт
+static uint64_t AllocateSection(uint64_t& file_size, uint64_t section_size) {
+    const uint64_t offset = file_size;
+    file_size = (file_size + section_size + 7) / 8 * 8;
+    return offset;
+}
+
+template <typename T>
+static void WriteSection(ofstream& out, uint64_t offset, const vector<T>& data) {
+    static const char padding[8] = {};
+    out.write(padding, offset - static_cast<uint64_t>(out.tellp()));
+    out.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(T));
+}
+
+template <typename Strings>
+static void CollectStrings(const Strings& strings, vector<uint64_t>& offsets, vector<char>& chars) {
+    offsets.push_back(0);
+    for (const auto& str : strings) {
+        chars.insert(chars.end(), str.begin(), str.end());
+        offsets.push_back(chars.size());
+    }
+}
+
+void SaveIndex(const SearchServer& search_server, const string& path) {
+    vector<TermId> terms;
+    for (TermId term_id = 0; term_id < search_server.term_to_document_freqs_.size(); ++term_id) {
+        if (!search_server.term_to_document_freqs_[term_id].empty()) {
+            terms.push_back(term_id);
+        }
+    }
+    sort(terms.begin(), terms.end(), [&search_server](TermId lhs, TermId rhs) {
+        return search_server.terms_.GetTerm(lhs) < search_server.terms_.GetTerm(rhs);
+    });
+    vector<uint32_t> file_term_ids(search_server.term_to_document_freqs_.size());
+    vector<string_view> term_words;
+    for (uint32_t i = 0; i < terms.size(); ++i) {
+        file_term_ids[terms[i]] = i;
+        term_words.push_back(search_server.terms_.GetTerm(terms[i]));
+    }
+
+    vector<IndexFileDocument> documents;
+    vector<IndexFileForwardEntry> forward_entries;
+    for (const auto& [document_id, ordinal] : search_server.document_to_ordinal_) {
+        const auto& term_freqs = search_server.document_term_freqs_[ordinal];
+        const uint64_t forward_begin = forward_entries.size();
+        for (const auto& [term_id, term_freq] : term_freqs) {
+            forward_entries.push_back({file_term_ids[term_id], term_freq});
+        }
+        sort(forward_entries.begin() + forward_begin, forward_entries.end(),
+             [](const IndexFileForwardEntry& lhs, const IndexFileForwardEntry& rhs) { return lhs.term_id < rhs.term_id; });
+        documents.push_back({document_id, search_server.ratings_[ordinal], static_cast<uint32_t>(search_server.statuses_[ordinal]),
+                             static_cast<uint32_t>(term_freqs.size()), forward_begin});
+    }
+
+    // В памяти списки упорядочены по внутренним номерам, в файле - по id документов
+    vector<IndexFilePostingRange> posting_ranges;
+    vector<int32_t> posting_ids;
+    vector<float> posting_freqs;
+    vector<pair<int32_t, float>> postings;
+    for (const TermId term_id : terms) {
+        IndexFilePostingRange range{posting_ids.size(), 0, 0.0f};
+        postings.clear();
+        search_server.term_to_document_freqs_[term_id].ForEach([&](int ordinal, float term_freq) {
+            postings.emplace_back(search_server.ordinal_to_document_[ordinal], term_freq);
+            range.max_term_freq = max(range.max_term_freq, term_freq);
+        });
+        sort(postings.begin(), postings.end());
+        for (const auto& [document_id, term_freq] : postings) {
+            posting_ids.push_back(document_id);
+            posting_freqs.push_back(term_freq);
+        }
+        range.count = static_cast<uint32_t>(postings.size());
+        posting_ranges.push_back(range);
+    }
+
+    vector<uint64_t> term_offsets, stop_word_offsets;
+    vector<char> term_chars, stop_word_chars;
+    CollectStrings(term_words, term_offsets, term_chars);
+    CollectStrings(search_server.stop_words_, stop_word_offsets, stop_word_chars);
+
+    IndexFileHeader header{};
+    memcpy(header.magic, INDEX_FILE_MAGIC, sizeof(INDEX_FILE_MAGIC));
+    header.version = INDEX_FILE_VERSION;
+    header.document_count = documents.size();
+    header.forward_entry_count = forward_entries.size();
+    header.term_count = terms.size();
+    header.stop_word_count = search_server.stop_words_.size();
+    header.posting_count = posting_ids.size();
+    uint64_t file_size = sizeof(IndexFileHeader);
+    header.documents_offset = AllocateSection(file_size, documents.size() * sizeof(IndexFileDocument));
+    header.forward_offset = AllocateSection(file_size, forward_entries.size() * sizeof(IndexFileForwardEntry));
+    header.term_offsets_offset = AllocateSection(file_size, term_offsets.size() * sizeof(uint64_t));
+    header.term_chars_offset = AllocateSection(file_size, term_chars.size());
+    header.stop_word_offsets_offset = AllocateSection(file_size, stop_word_offsets.size() * sizeof(uint64_t));
+    header.stop_word_chars_offset = AllocateSection(file_size, stop_word_chars.size());
+    header.posting_ranges_offset = AllocateSection(file_size, posting_ranges.size() * sizeof(IndexFilePostingRange));
+    header.posting_ids_offset = AllocateSection(file_size, posting_ids.size() * sizeof(int32_t));
+    header.posting_freqs_offset = AllocateSection(file_size, posting_freqs.size() * sizeof(float));
+    header.file_size = file_size;
+
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out) {
+        throw invalid_argument("cannot create index file "s + path);
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    WriteSection(out, header.documents_offset, documents);
+    WriteSection(out, header.forward_offset, forward_entries);
+    WriteSection(out, header.term_offsets_offset, term_offsets);
+    WriteSection(out, header.term_chars_offset, term_chars);
+    WriteSection(out, header.stop_word_offsets_offset, stop_word_offsets);
+    WriteSection(out, header.stop_word_chars_offset, stop_word_chars);
+    WriteSection(out, header.posting_ranges_offset, posting_ranges);
+    WriteSection(out, header.posting_ids_offset, posting_ids);
+    WriteSection(out, header.posting_freqs_offset, posting_freqs);
+    WriteSection(out, file_size, vector<char>{});
+    if (!out) {
+        throw invalid_argument("cannot write index file "s + path);
+    }
+}
+
+// Секция из count элементов размера element_size целиком лежит в файле размера size
+static bool HasSection(size_t size, uint64_t offset, uint64_t count, uint64_t element_size) {
+    return offset % 8 == 0 && offset <= size && count <= (size - offset) / element_size;
+}
+
+// Границы строк начинаются с 0, не убывают, а последняя граница не выходит за файл
+static bool HasStrings(const char* data, size_t size, uint64_t offsets_offset, uint64_t chars_offset, uint64_t count) {
+    if (count == numeric_limits<uint64_t>::max() || !HasSection(size, offsets_offset, count + 1, sizeof(uint64_t))) {
+        return false;
+    }
+    const uint64_t* offsets = reinterpret_cast<const uint64_t*>(data + offsets_offset);
+    if (offsets[0] != 0 || !is_sorted(offsets, offsets + count + 1)) {
+        return false;
+    }
+    return HasSection(size, chars_offset, offsets[count], 1);
+}
+
+static bool IsValidIndex(const char* data, size_t size) {
+    const IndexFileHeader& header = *reinterpret_cast<const IndexFileHeader*>(data);
+    if (memcmp(header.magic, INDEX_FILE_MAGIC, sizeof(INDEX_FILE_MAGIC)) != 0 || header.version != INDEX_FILE_VERSION
+            || header.file_size != size || header.document_count > static_cast<uint64_t>(numeric_limits<int>::max())
+            || header.term_count > numeric_limits<uint32_t>::max()) {
+        return false;
+    }
+    if (!HasSection(size, header.documents_offset, header.document_count, sizeof(IndexFileDocument))
+            || !HasSection(size, header.forward_offset, header.forward_entry_count, sizeof(IndexFileForwardEntry))
+            || !HasStrings(data, size, header.term_offsets_offset, header.term_chars_offset, header.term_count)
+            || !HasStrings(data, size, header.stop_word_offsets_offset, header.stop_word_chars_offset, header.stop_word_count)
+            || !HasSection(size, header.posting_ranges_offset, header.term_count, sizeof(IndexFilePostingRange))
+            || !HasSection(size, header.posting_ids_offset, header.posting_count, sizeof(int32_t))
+            || !HasSection(size, header.posting_freqs_offset, header.posting_count, sizeof(float))) {
+        return false;
+    }
+    const IndexFileDocument* documents = reinterpret_cast<const IndexFileDocument*>(data + header.documents_offset);
+    for (uint64_t i = 0; i < header.document_count; ++i) {
+        const IndexFileDocument& document = documents[i];
+        if (document.id < 0 || (i > 0 && documents[i - 1].id >= document.id) || document.status >= DOCUMENT_STATUS_COUNT
+                || document.forward_begin > header.forward_entry_count
+                || document.forward_count > header.forward_entry_count - document.forward_begin) {
+            return false;
+        }
+    }
+    const IndexFilePostingRange* ranges = reinterpret_cast<const IndexFilePostingRange*>(data + header.posting_ranges_offset);
+    return all_of(ranges, ranges + header.term_count, [&header](const IndexFilePostingRange& range) {
+        return range.begin <= header.posting_count && range.count <= header.posting_count - range.begin;
+    });
+}
+
+MappedSearchServer::MappedSearchServer(const string& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw invalid_argument("cannot open index file "s + path);
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < sizeof(IndexFileHeader)) {
+        close(fd);
+        throw invalid_argument("invalid index file "s + path);
+    }
+    size_ = file_stat.st_size;
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw invalid_argument("cannot map index file "s + path);
+    }
+    data_ = static_cast<const char*>(data);
+    header_ = GetSection<IndexFileHeader>(0);
+    if (!IsValidIndex(data_, size_)) {
+        munmap(data, size_);
+        throw invalid_argument("invalid index file "s + path);
+    }
+}
+
+MappedSearchServer::~MappedSearchServer() {
+    munmap(const_cast<char*>(data_), size_);
+}
+
+int MappedSearchServer::GetDocumentCount() const {
+    return static_cast<int>(header_->document_count);
+}
+
+vector<Document> MappedSearchServer::FindTopDocuments(string_view raw_query, DocumentStatus status, size_t max_result_count) const {
+    return FindTopDocuments(raw_query, [status]([[maybe_unused]] int document_id, DocumentStatus document_status, [[maybe_unused]] int document_rating)
+            { return document_status == status; }, max_result_count);
+}
+
+tuple<vector<string_view>, DocumentStatus> MappedSearchServer::MatchDocument(string_view raw_query, int document_id) const {
+    const Query query = ParseQuery(raw_query);
+    const IndexFileDocument* document = FindDocument(document_id);
+    if (document == nullptr) {
+        throw out_of_range("document not found"s);
+    }
+    const DocumentStatus status = static_cast<DocumentStatus>(document->status);
+    for (const uint32_t term_id : query.minus_terms) {
+        if (ContainsTerm(*document, term_id)) {
+            return {vector<string_view>{}, status};
+        }
+    }
+    // Номера терминов упорядочены как слова, поэтому результат уже отсортирован
+    vector<string_view> matched_words;
+    for (const uint32_t term_id : query.plus_terms) {
+        if (ContainsTerm(*document, term_id)) {
+            matched_words.push_back(GetString(GetSection<uint64_t>(header_->term_offsets_offset),
+                                              GetSection<char>(header_->term_chars_offset), term_id));
+        }
+    }
+    return {matched_words, status};
+}
+
+string_view MappedSearchServer::GetString(const uint64_t* offsets, const char* chars, uint64_t index) {
+    return string_view(chars + offsets[index], offsets[index + 1] - offsets[index]);
+}
+
+optional<uint64_t> MappedSearchServer::FindString(const uint64_t* offsets, const char* chars, uint64_t count, string_view str) {
+    uint64_t left = 0;
+    uint64_t right = count;
+    while (left < right) {
+        const uint64_t middle = left + (right - left) / 2;
+        if (GetString(offsets, chars, middle) < str) {
+            left = middle + 1;
+        } else {
+            right = middle;
+        }
+    }
+    if (left < count && GetString(offsets, chars, left) == str) {
+        return left;
+    }
+    return nullopt;
+}
+
+optional<uint32_t> MappedSearchServer::FindTerm(string_view word) const {
+    const auto index = FindString(GetSection<uint64_t>(header_->term_offsets_offset), GetSection<char>(header_->term_chars_offset),
+                                  header_->term_count, word);
+    if (!index) {
+        return nullopt;
+    }
+    return static_cast<uint32_t>(*index);
+}
+
+bool MappedSearchServer::IsStopWord(string_view word) const {
+    return FindString(GetSection<uint64_t>(header_->stop_word_offsets_offset), GetSection<char>(header_->stop_word_chars_offset),
+                      header_->stop_word_count, word).has_value();
+}
+
+const IndexFileDocument* MappedSearchServer::FindDocument(int document_id) const {
+    const IndexFileDocument* first = GetSection<IndexFileDocument>(header_->documents_offset);
+    const IndexFileDocument* last = first + header_->document_count;
+    const IndexFileDocument* document = lower_bound(first, last, document_id, [](const IndexFileDocument& record, int id) {
+        return record.id < id;
+    });
+    return document != last && document->id == document_id ? document : nullptr;
+}
+
+bool MappedSearchServer::ContainsTerm(const IndexFileDocument& document, uint32_t term_id) const {
+    const IndexFileForwardEntry* first = GetSection<IndexFileForwardEntry>(header_->forward_offset) + document.forward_begin;
+    const IndexFileForwardEntry* last = first + document.forward_count;
+    const IndexFileForwardEntry* entry = lower_bound(first, last, term_id, [](const IndexFileForwardEntry& forward_entry, uint32_t id) {
+        return forward_entry.term_id < id;
+    });
+    return entry != last && entry->term_id == term_id;
+}
+
+MappedSearchServer::Query MappedSearchServer::ParseQuery(string_view raw_query) const {
+    Query query;
+    for (const string_view word : SplitIntoWords(raw_query)) {
+        const bool is_minus = SearchServer::IsMinusWord(word);
+        if (IsStopWord(word)) {
+            continue;
+        }
+        const auto term_id = FindTerm(is_minus ? word.substr(1) : word);
+        if (!term_id) {
+            continue;
+        }
+        if (is_minus) {
+            query.minus_terms.insert(*term_id);
+        } else {
+            query.plus_terms.insert(*term_id);
+        }
+    }
+    return query;
+}
+
+static void CheckPostingId(int32_t document_id, size_t document_id_bound) {
+    if (document_id < 0 || static_cast<size_t>(document_id) >= document_id_bound) {
+        throw invalid_argument("invalid document id in index file"s);
+    }
+}
+
+MappedSearchServer::PostingCursor::PostingCursor(const int32_t* ids, const float* freqs, const IndexFilePostingRange& range,
+                                                 size_t document_id_bound)
+    : ids_(ids + range.begin)
+    , freqs_(freqs + range.begin)
+    , count_(range.count)
+    , max_term_freq_(range.max_term_freq)
+    , document_id_bound_(document_id_bound) {
+    CheckPosition(-1);
+}
+
+void MappedSearchServer::PostingCursor::Next() {
+    const int previous_id = ids_[position_];
+    ++position_;
+    CheckPosition(previous_id);
+}
+
+void MappedSearchServer::PostingCursor::SeekTo(int document_id) {
+    if (AtEnd() || ids_[position_] >= document_id) {
+        return;
+    }
+    const int previous_id = ids_[position_];
+    position_ = lower_bound(ids_ + position_, ids_ + count_, document_id) - ids_;
+    CheckPosition(previous_id);
+}
+
+// Частота сравнивается через отрицание, чтобы NaN тоже считался ошибкой
+void MappedSearchServer::PostingCursor::CheckPosition(int previous_id) const {
+    if (AtEnd()) {
+        return;
+    }
+    CheckPostingId(ids_[position_], document_id_bound_);
+    if (ids_[position_] <= previous_id || !(freqs_[position_] <= max_term_freq_)) {
+        throw invalid_argument("invalid posting list in index file"s);
+    }
+}
+
+bool MappedSearchServer::IsExcluded(const Query& query, const IndexFileDocument& document) const {
+    return any_of(query.minus_terms.begin(), query.minus_terms.end(), [this, &document](uint32_t term_id) {
+        return ContainsTerm(document, term_id);
+    });
+}
+
+pmr::vector<MappedSearchServer::ScoredTerm> MappedSearchServer::GetScoredTerms(const Query& query, pmr::memory_resource* resource) const {
+    const IndexFilePostingRange* ranges = GetSection<IndexFilePostingRange>(header_->posting_ranges_offset);
+    const int32_t* posting_ids = GetSection<int32_t>(header_->posting_ids_offset);
+    const float* posting_freqs = GetSection<float>(header_->posting_freqs_offset);
+    const IndexFileDocument* documents = GetSection<IndexFileDocument>(header_->documents_offset);
+    const size_t document_id_bound = header_->document_count == 0 ? 0 : documents[header_->document_count - 1].id + 1;
+    pmr::vector<ScoredTerm> terms(resource);
+    for (const uint32_t term_id : query.plus_terms) {
+        const IndexFilePostingRange& range = ranges[term_id];
+        if (range.count == 0) {
+            continue;
+        }
+        const double inverse_document_freq = log(header_->document_count * 1.0 / range.count);
+        terms.push_back({PostingCursor(posting_ids, posting_freqs, range, document_id_bound), inverse_document_freq,
+                         range.max_term_freq * inverse_document_freq, 0.0});
+    }
+    sort(terms.begin(), terms.end(), [](const ScoredTerm& lhs, const ScoredTerm& rhs) {
+        return lhs.max_score < rhs.max_score;
+    });
+    double max_score_sum = 0.0;
+    for (ScoredTerm& term : terms) {
+        max_score_sum += term.max_score;
+        term.max_score_prefix = max_score_sum;
+    }
+    return terms;
+}
@@ -0,0 +1,216 @@
+#pragma once
+
+#include "search_server.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+// Формат файла индекса. Все секции выровнены по 8 байт и читаются прямо из отображённой памяти.
+// Идентификаторы терминов при сохранении перенумеровываются в лексикографическом порядке,
+// поэтому слово запроса находится двоичным поиском без отдельной хеш-таблицы.
+struct IndexFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t document_count;
+    uint64_t forward_entry_count;
+    uint64_t term_count;
+    uint64_t stop_word_count;
+    uint64_t posting_count;
+    uint64_t documents_offset;      // IndexFileDocument[document_count], по возрастанию id
+    uint64_t forward_offset;        // IndexFileForwardEntry[forward_entry_count]
+    uint64_t term_offsets_offset;   // uint64_t[term_count + 1] - границы слов в term_chars
+    uint64_t term_chars_offset;
+    uint64_t stop_word_offsets_offset;
+    uint64_t stop_word_chars_offset;
+    uint64_t posting_ranges_offset; // IndexFilePostingRange[term_count]
+    uint64_t posting_ids_offset;    // int32_t[posting_count]
+    uint64_t posting_freqs_offset;  // float[posting_count]
+    uint64_t file_size;
+};
+
+struct IndexFileDocument {
+    int32_t id;
+    int32_t rating;
+    uint32_t status;
+    uint32_t forward_count;
+    uint64_t forward_begin;
+};
+
+struct IndexFileForwardEntry {
+    uint32_t term_id;
+    float term_freq;
+};
+
+struct IndexFilePostingRange {
+    uint64_t begin;
+    uint32_t count;
+    // Наибольшая частота термина в списке - верхняя граница его вклада для MaxScore
+    float max_term_freq;
+};
+
+inline constexpr char INDEX_FILE_MAGIC[8] = {'S', 'S', 'I', 'N', 'D', 'E', 'X', '\0'};
+inline constexpr uint32_t INDEX_FILE_VERSION = 1;
+
+// Сохраняет индекс в файл. Удалённые документы и опустевшие термины не записываются
+void SaveIndex(const SearchServer& search_server, const std::string& path);
+
+// Сервер только для чтения, работающий прямо с отображённым в память файлом индекса:
+// загрузка не разбирает данные, страницы подгружаются системой по мере обращения.
+// Результаты совпадают с SearchServer, из которого сохранён индекс.
+// Запросы выполняются MaxScore, как в SearchServer, с границами вклада терминов из файла.
+// При открытии проверяются заголовок, границы всех секций и таблицы документов, терминов
+// и стоп-слов, поэтому усечённый или испорченный файл даёт invalid_argument. Сами списки
+// вхождений не читаются заранее: при обходе проверяется, что id документов возрастают и лежат
+// в границах, а частоты не превышают границу списка.
+class MappedSearchServer {
+public:
+    explicit MappedSearchServer(const std::string& path);
+    MappedSearchServer(const MappedSearchServer&) = delete;
+    MappedSearchServer& operator=(const MappedSearchServer&) = delete;
+    ~MappedSearchServer();
+
+    int GetDocumentCount() const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status = DocumentStatus::ACTUAL,
+                                           size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+    template <typename KeyMapper>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, const KeyMapper& key_mapper,
+                                           size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const {
+        std::vector<Document> top_documents;
+        if (max_result_count == 0) {
+            return top_documents;
+        }
+        top_documents.reserve(max_result_count + 1);
+        QueryArena arena;
+        const Query query = ParseQuery(raw_query);
+        std::pmr::vector<ScoredTerm> terms = GetScoredTerms(query, arena.GetResource());
+        size_t first_essential = 0;
+        while (true) {
+            int candidate_id = 0;
+            bool has_candidate = false;
+            for (size_t i = first_essential; i < terms.size(); ++i) {
+                if (!terms[i].cursor.AtEnd() && (!has_candidate || terms[i].cursor.GetDocumentId() < candidate_id)) {
+                    candidate_id = terms[i].cursor.GetDocumentId();
+                    has_candidate = true;
+                }
+            }
+            if (!has_candidate) {
+                break;
+            }
+            double relevance = 0.0;
+            for (size_t i = first_essential; i < terms.size(); ++i) {
+                PostingCursor& cursor = terms[i].cursor;
+                if (!cursor.AtEnd() && cursor.GetDocumentId() == candidate_id) {
+                    relevance += cursor.GetTermFreq() * terms[i].inverse_document_freq;
+                    cursor.Next();
+                }
+            }
+            const bool is_full = top_documents.size() == max_result_count;
+            bool is_pruned = false;
+            for (size_t i = first_essential; i-- > 0; ) {
+                if (is_full && relevance + terms[i].max_score_prefix < top_documents.front().relevance - EPSILON) {
+                    is_pruned = true;
+                    break;
+                }
+                PostingCursor& cursor = terms[i].cursor;
+                cursor.SeekTo(candidate_id);
+                if (!cursor.AtEnd() && cursor.GetDocumentId() == candidate_id) {
+                    relevance += cursor.GetTermFreq() * terms[i].inverse_document_freq;
+                }
+            }
+            if (is_pruned) {
+                continue;
+            }
+            const IndexFileDocument* document = FindDocument(candidate_id);
+            if (document == nullptr) {
+                throw std::invalid_argument("invalid document id in index file");
+            }
+            if (IsExcluded(query, *document)) {
+                continue;
+            }
+            const DocumentStatus status = static_cast<DocumentStatus>(document->status);
+            if (!key_mapper(document->id, status, document->rating)) {
+                continue;
+            }
+            SearchServer::OfferTopDocument(top_documents, Document(document->id, relevance, document->rating), max_result_count);
+            if (top_documents.size() == max_result_count) {
+                const double threshold = top_documents.front().relevance - EPSILON;
+                while (first_essential < terms.size() && terms[first_essential].max_score_prefix < threshold) {
+                    ++first_essential;
+                }
+            }
+        }
+        std::sort_heap(top_documents.begin(), top_documents.end(), SearchServer::IsMoreRelevant);
+        return top_documents;
+    }
+    // Найденные слова ссылаются на отображённый файл и остаются валидными, пока жив сервер
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
+
+private:
+    struct Query {
+        std::set<uint32_t> plus_terms;
+        std::set<uint32_t> minus_terms;
+    };
+
+    // Обход списка вхождений термина в файле с проверкой каждого вхождения, на котором остановился курсор
+    class PostingCursor {
+    public:
+        PostingCursor(const int32_t* ids, const float* freqs, const IndexFilePostingRange& range, size_t document_id_bound);
+        bool AtEnd() const {
+            return position_ == count_;
+        }
+        int GetDocumentId() const {
+            return ids_[position_];
+        }
+        float GetTermFreq() const {
+            return freqs_[position_];
+        }
+        void Next();
+        // Переходит к первому вхождению с id >= document_id
+        void SeekTo(int document_id);
+
+    private:
+        void CheckPosition(int previous_id) const;
+
+        const int32_t* ids_;
+        const float* freqs_;
+        size_t count_;
+        float max_term_freq_;
+        size_t document_id_bound_;
+        size_t position_ = 0;
+    };
+
+    struct ScoredTerm {
+        PostingCursor cursor;
+        double inverse_document_freq;
+        double max_score;
+        // Сумма границ вклада этого термина и всех терминов с меньшей границей
+        double max_score_prefix;
+    };
+
+    template <typename T>
+    const T* GetSection(uint64_t offset) const {
+        return reinterpret_cast<const T*>(data_ + offset);
+    }
+    static std::string_view GetString(const uint64_t* offsets, const char* chars, uint64_t index);
+    static std::optional<uint64_t> FindString(const uint64_t* offsets, const char* chars, uint64_t count, std::string_view str);
+    std::optional<uint32_t> FindTerm(std::string_view word) const;
+    bool IsStopWord(std::string_view word) const;
+    const IndexFileDocument* FindDocument(int document_id) const;
+    bool ContainsTerm(const IndexFileDocument& document, uint32_t term_id) const;
+    Query ParseQuery(std::string_view raw_query) const;
+    bool IsExcluded(const Query& query, const IndexFileDocument& document) const;
+    // Плюс-термины запроса по возрастанию границы вклада
+    std::pmr::vector<ScoredTerm> GetScoredTerms(const Query& query, std::pmr::memory_resource* resource) const;
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    const IndexFileHeader* header_ = nullptr;
+};
@@ -0,0 +1,197 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <mutex>
+#include <sstream>
+
+using namespace std;
+
+static const int LATENCY_SUBBUCKET_BITS = 2;
+static const array<const char*, METRIC_STAGE_COUNT> STAGE_NAMES = {
+    "parse", "filter", "accumulate", "sort", "top_k", "add_document", "remove_document"};
+static const array<const char*, METRIC_COUNTER_COUNT> COUNTER_NAMES = {"postings_scanned", "documents_scored"};
+
+int GetLatencyBucket(uint64_t latency_ns) {
+    const uint64_t subbucket_count = 1 << LATENCY_SUBBUCKET_BITS;
+    if (latency_ns < subbucket_count) {
+        return static_cast<int>(latency_ns);
+    }
+    int high_bit = 0;
+    while ((latency_ns >> (high_bit + 1)) != 0) {
+        ++high_bit;
+    }
+    const uint64_t subbucket = (latency_ns >> (high_bit - LATENCY_SUBBUCKET_BITS)) & (subbucket_count - 1);
+    const uint64_t bucket = ((high_bit - LATENCY_SUBBUCKET_BITS + 1) << LATENCY_SUBBUCKET_BITS) + subbucket;
+    return static_cast<int>(min<uint64_t>(bucket, LATENCY_BUCKET_COUNT - 1));
+}
+
+uint64_t GetLatencyBucketBound(int bucket) {
+    if (bucket < (1 << LATENCY_SUBBUCKET_BITS)) {
+        return bucket + 1;
+    }
+    const int octave = bucket >> LATENCY_SUBBUCKET_BITS;
+    const uint64_t mantissa = (1 << LATENCY_SUBBUCKET_BITS) + (bucket & ((1 << LATENCY_SUBBUCKET_BITS) - 1)) + 1;
+    return mantissa << (octave - 1);
+}
+
+double MetricsSnapshot::StageStats::GetMeanNs() const {
+    return count == 0 ? 0.0 : total_ns * 1.0 / count;
+}
+
+uint64_t MetricsSnapshot::StageStats::GetPercentileNs(double quantile) const {
+    if (count == 0) {
+        return 0;
+    }
+    const uint64_t rank = max<uint64_t>(1, static_cast<uint64_t>(ceil(clamp(quantile, 0.0, 1.0) * count)));
+    uint64_t passed_count = 0;
+    int bucket = 0;
+    for (; bucket < LATENCY_BUCKET_COUNT - 1; ++bucket) {
+        passed_count += histogram[bucket];
+        if (passed_count >= rank) {
+            break;
+        }
+    }
+    return GetLatencyBucketBound(bucket);
+}
+
+string MetricsSnapshot::ToText() const {
+    ostringstream out;
+    out << "stage count mean_ns p50_ns p99_ns max_ns\n"s;
+    for (int stage = 0; stage < METRIC_STAGE_COUNT; ++stage) {
+        const StageStats& stats = stages[stage];
+        out << STAGE_NAMES[stage] << ' ' << stats.count << ' ' << static_cast<uint64_t>(stats.GetMeanNs()) << ' '
+            << stats.GetPercentileNs(0.5) << ' ' << stats.GetPercentileNs(0.99) << ' ' << stats.GetPercentileNs(1.0) << '\n';
+    }
+    for (int counter = 0; counter < METRIC_COUNTER_COUNT; ++counter) {
+        out << COUNTER_NAMES[counter] << ' ' << counters[counter] << '\n';
+    }
+    return out.str();
+}
+
+string MetricsSnapshot::ToJson() const {
+    ostringstream out;
+    out << "{\"stages\":{"s;
+    for (int stage = 0; stage < METRIC_STAGE_COUNT; ++stage) {
+        const StageStats& stats = stages[stage];
+        out << (stage == 0 ? "" : ",") << '"' << STAGE_NAMES[stage] << "\":{\"count\":"s << stats.count
+            << ",\"total_ns\":"s << stats.total_ns << ",\"mean_ns\":"s << static_cast<uint64_t>(stats.GetMeanNs())
+            << ",\"p50_ns\":"s << stats.GetPercentileNs(0.5) << ",\"p99_ns\":"s << stats.GetPercentileNs(0.99)
+            << ",\"max_ns\":"s << stats.GetPercentileNs(1.0) << '}';
+    }
+    out << "},\"counters\":{"s;
+    for (int counter = 0; counter < METRIC_COUNTER_COUNT; ++counter) {
+        out << (counter == 0 ? "" : ",") << '"' << COUNTER_NAMES[counter] << "\":"s << counters[counter];
+    }
+    out << "}}"s;
+    return out.str();
+}
+
+// Значения блока меняет только поток-владелец, остальные их только читают
+struct ThreadMetrics {
+    array<array<atomic<uint64_t>, LATENCY_BUCKET_COUNT>, METRIC_STAGE_COUNT> histograms{};
+    array<atomic<uint64_t>, METRIC_STAGE_COUNT> total_ns{};
+    array<atomic<uint64_t>, METRIC_COUNTER_COUNT> counters{};
+    // Под мьютексом реестра
+    bool is_owned = false;
+};
+
+struct ThreadMetricsRegistry {
+    mutex registry_mutex;
+    // deque не перемещает блоки при добавлении
+    deque<ThreadMetrics> blocks;
+};
+
+static ThreadMetricsRegistry& GetRegistry() {
+    static ThreadMetricsRegistry registry;
+    return registry;
+}
+
+class ThreadMetricsOwner {
+public:
+    ThreadMetricsOwner() {
+        ThreadMetricsRegistry& registry = GetRegistry();
+        lock_guard guard(registry.registry_mutex);
+        for (ThreadMetrics& block : registry.blocks) {
+            if (!block.is_owned) {
+                block_ = &block;
+                break;
+            }
+        }
+        if (block_ == nullptr) {
+            block_ = &registry.blocks.emplace_back();
+        }
+        block_->is_owned = true;
+    }
+    ~ThreadMetricsOwner() {
+        lock_guard guard(GetRegistry().registry_mutex);
+        block_->is_owned = false;
+    }
+
+    ThreadMetrics& GetBlock() {
+        return *block_;
+    }
+
+private:
+    ThreadMetrics* block_ = nullptr;
+};
+
+static ThreadMetrics& GetThreadMetrics() {
+    thread_local ThreadMetricsOwner owner;
+    return owner.GetBlock();
+}
+
+static void Increase(atomic<uint64_t>& value, uint64_t delta) {
+    value.store(value.load(memory_order_relaxed) + delta, memory_order_relaxed);
+}
+
+void Metrics::RecordStageEnabled(MetricStage stage, uint64_t duration_ns) {
+    ThreadMetrics& block = GetThreadMetrics();
+    const int stage_index = static_cast<int>(stage);
+    Increase(block.histograms[stage_index][GetLatencyBucket(duration_ns)], 1);
+    Increase(block.total_ns[stage_index], duration_ns);
+}
+
+void Metrics::AddCounterEnabled(MetricCounter counter, uint64_t value) {
+    Increase(GetThreadMetrics().counters[static_cast<int>(counter)], value);
+}
+
+MetricsSnapshot Metrics::GetSnapshot() {
+    MetricsSnapshot snapshot;
+    ThreadMetricsRegistry& registry = GetRegistry();
+    lock_guard guard(registry.registry_mutex);
+    for (const ThreadMetrics& block : registry.blocks) {
+        for (int stage = 0; stage < METRIC_STAGE_COUNT; ++stage) {
+            MetricsSnapshot::StageStats& stats = snapshot.stages[stage];
+            for (int bucket = 0; bucket < LATENCY_BUCKET_COUNT; ++bucket) {
+                const uint64_t count = block.histograms[stage][bucket].load(memory_order_relaxed);
+                stats.histogram[bucket] += count;
+                stats.count += count;
+            }
+            stats.total_ns += block.total_ns[stage].load(memory_order_relaxed);
+        }
+        for (int counter = 0; counter < METRIC_COUNTER_COUNT; ++counter) {
+            snapshot.counters[counter] += block.counters[counter].load(memory_order_relaxed);
+        }
+    }
+    return snapshot;
+}
+
+void Metrics::Reset() {
+    ThreadMetricsRegistry& registry = GetRegistry();
+    lock_guard guard(registry.registry_mutex);
+    for (ThreadMetrics& block : registry.blocks) {
+        for (auto& histogram : block.histograms) {
+            for (atomic<uint64_t>& count : histogram) {
+                count.store(0, memory_order_relaxed);
+            }
+        }
+        for (atomic<uint64_t>& total_ns : block.total_ns) {
+            total_ns.store(0, memory_order_relaxed);
+        }
+        for (atomic<uint64_t>& counter : block.counters) {
+            counter.store(0, memory_order_relaxed);
+        }
+    }
+}
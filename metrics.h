@@ -0,0 +1,121 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Гистограмма времени в наносекундах: интервалы по четверти степени двойки,
+// значения меньше 4 нс - по одному на интервал, всё дольше ~8.6 с - в последнем интервале
+const int LATENCY_BUCKET_COUNT = 128;
+
+int GetLatencyBucket(uint64_t latency_ns);
+// Верхняя граница интервала, не включительно
+uint64_t GetLatencyBucketBound(int bucket);
+
+// Этапы, время которых измеряется. Этапы FindTopDocuments:
+// PARSE - разбор запроса, FILTER - маска допустимых статусов, ACCUMULATE - обход списков вхождений
+// (для MaxScore - вместе с отбором лучших), SORT - упорядочение найденных документов и результата,
+// TOP_K - отбор лучших документов с key_mapper
+enum class MetricStage {
+    PARSE,
+    FILTER,
+    ACCUMULATE,
+    SORT,
+    TOP_K,
+    ADD_DOCUMENT,
+    REMOVE_DOCUMENT
+};
+const int METRIC_STAGE_COUNT = 7;
+
+enum class MetricCounter {
+    // Прочитанные вхождения
+    POSTINGS_SCANNED,
+    // Документы, релевантность которых подсчитана
+    DOCUMENTS_SCORED
+};
+const int METRIC_COUNTER_COUNT = 2;
+
+struct MetricsSnapshot {
+    struct StageStats {
+        uint64_t count = 0;
+        uint64_t total_ns = 0;
+        std::array<uint64_t, LATENCY_BUCKET_COUNT> histogram{};
+
+        double GetMeanNs() const;
+        // Верхняя граница интервала, в который попадает доля quantile измерений
+        uint64_t GetPercentileNs(double quantile) const;
+    };
+
+    std::array<StageStats, METRIC_STAGE_COUNT> stages;
+    std::array<uint64_t, METRIC_COUNTER_COUNT> counters{};
+
+    std::string ToText() const;
+    std::string ToJson() const;
+};
+
+// Метрики процесса. Каждый поток пишет в свой блок счётчиков без блокировок и без
+// атомарных read-modify-write, снимок суммирует блоки всех потоков. Блок завершившегося
+// потока со всеми значениями переходит к следующему новому потоку.
+// Выключенные метрики стоят одной проверки флага на измерение
+class Metrics {
+public:
+    static void SetEnabled(bool is_enabled) {
+        is_enabled_.store(is_enabled, std::memory_order_relaxed);
+    }
+    static bool IsEnabled() {
+        return is_enabled_.load(std::memory_order_relaxed);
+    }
+    static void RecordStage(MetricStage stage, uint64_t duration_ns) {
+        if (IsEnabled()) {
+            RecordStageEnabled(stage, duration_ns);
+        }
+    }
+    static void AddCounter(MetricCounter counter, uint64_t value) {
+        if (IsEnabled()) {
+            AddCounterEnabled(counter, value);
+        }
+    }
+    static MetricsSnapshot GetSnapshot();
+    // Измерения, идущие одновременно со сбросом, могут его пережить
+    static void Reset();
+
+private:
+    static void RecordStageEnabled(MetricStage stage, uint64_t duration_ns);
+    static void AddCounterEnabled(MetricCounter counter, uint64_t value);
+
+    inline static std::atomic<bool> is_enabled_ = false;
+};
+
+// Измеряет время этапа от создания до Stop или разрушения. Часы не читаются, если метрики выключены
+class MetricTimer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit MetricTimer(MetricStage stage)
+        : stage_(stage)
+        , is_running_(Metrics::IsEnabled()) {
+        if (is_running_) {
+            start_time_ = Clock::now();
+        }
+    }
+    MetricTimer(const MetricTimer&) = delete;
+    MetricTimer& operator=(const MetricTimer&) = delete;
+
+    ~MetricTimer() {
+        Stop();
+    }
+
+    void Stop() {
+        if (is_running_) {
+            is_running_ = false;
+            Metrics::RecordStage(stage_, std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_time_).count());
+        }
+    }
+
+private:
+    const MetricStage stage_;
+    bool is_running_;
+    Clock::time_point start_time_;
+};
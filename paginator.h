@@ -31,12 +31,16 @@ public:
     using PagesIterator = typename std::vector<IteratorRange<Iterator>>::const_iterator;
     Paginator(Iterator first, Iterator last, int page_size = 5)
     {
+        // Длина страницы считается по ходу обхода: distance для двунаправленных итераторов линейна
         Iterator PageStart = first;
+        int page_length = 0;
         for (Iterator i = first; i != last; ++i) {
-            if ( (distance(first,i) > 0) && (distance(first,i) % page_size == 0) ) {
+            if (page_length == page_size) {
                 pages_.push_back(IteratorRange(PageStart,i));
                 PageStart = i;
+                page_length = 0;
             }
+            ++page_length;
         }
         pages_.push_back(IteratorRange(PageStart,last));
     }
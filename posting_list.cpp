@@ -0,0 +1,152 @@
+#include "posting_list.h"
+
+#include <algorithm>
+
+using namespace std;
+
+PostingList::Cursor::Cursor(const PostingList& postings)
+    : postings_(&postings) {
+    SkipRemoved();
+}
+
+bool PostingList::Cursor::AtEnd() const {
+    return position_ == postings_->document_ids_.size();
+}
+
+int PostingList::Cursor::GetDocumentId() const {
+    return postings_->document_ids_[position_];
+}
+
+float PostingList::Cursor::GetTermFreq() const {
+    return postings_->term_freqs_[position_];
+}
+
+void PostingList::Cursor::Next() {
+    ++position_;
+    SkipRemoved();
+}
+
+void PostingList::Cursor::SeekTo(int document_id) {
+    const vector<int>& document_ids = postings_->document_ids_;
+    if (AtEnd() || document_ids[position_] >= document_id) {
+        return;
+    }
+    // Экспоненциальный поиск: при плотных запросах цель обычно рядом с текущей позицией
+    size_t step = 1;
+    size_t low = position_;
+    size_t high = position_ + step;
+    while (high < document_ids.size() && document_ids[high] < document_id) {
+        low = high;
+        step *= 2;
+        high = position_ + step;
+    }
+    high = min(high, document_ids.size());
+    position_ = lower_bound(document_ids.begin() + low, document_ids.begin() + high, document_id) - document_ids.begin();
+    SkipRemoved();
+}
+
+void PostingList::Cursor::SkipRemoved() {
+    while (!AtEnd() && postings_->term_freqs_[position_] == removed_mark_) {
+        ++position_;
+    }
+}
+
+void PostingList::Add(int document_id, float term_freq) {
+    max_term_freq_ = max(max_term_freq_, term_freq);
+    if (document_ids_.empty() || document_ids_.back() < document_id) {
+        document_ids_.push_back(document_id);
+        term_freqs_.push_back(term_freq);
+        return;
+    }
+    const size_t position = FindPosition(document_id);
+    if (position < document_ids_.size() && document_ids_[position] == document_id) {
+        if (term_freqs_[position] == removed_mark_) {
+            --removed_count_;
+        }
+        term_freqs_[position] = term_freq;
+        return;
+    }
+    document_ids_.insert(document_ids_.begin() + position, document_id);
+    term_freqs_.insert(term_freqs_.begin() + position, term_freq);
+}
+
+bool PostingList::Remove(int document_id) {
+    if (!MarkRemoved(document_id)) {
+        return false;
+    }
+    CompactIfSparse();
+    return true;
+}
+
+bool PostingList::MarkRemoved(int document_id) {
+    const size_t position = FindPosition(document_id);
+    if (position == document_ids_.size() || document_ids_[position] != document_id
+            || term_freqs_[position] == removed_mark_) {
+        return false;
+    }
+    term_freqs_[position] = removed_mark_;
+    ++removed_count_;
+    return true;
+}
+
+void PostingList::CompactIfSparse() {
+    if (removed_count_ * 2 > document_ids_.size()) {
+        Compact();
+    }
+}
+
+void PostingList::Compact() {
+    size_t kept = 0;
+    max_term_freq_ = 0.0f;
+    for (size_t i = 0; i < document_ids_.size(); ++i) {
+        if (term_freqs_[i] != removed_mark_) {
+            document_ids_[kept] = document_ids_[i];
+            term_freqs_[kept] = term_freqs_[i];
+            max_term_freq_ = max(max_term_freq_, term_freqs_[i]);
+            ++kept;
+        }
+    }
+    document_ids_.resize(kept);
+    term_freqs_.resize(kept);
+    document_ids_.shrink_to_fit();
+    term_freqs_.shrink_to_fit();
+    removed_count_ = 0;
+}
+
+void PostingList::Renumber(const vector<int>& new_ids) {
+    size_t kept = 0;
+    max_term_freq_ = 0.0f;
+    for (size_t i = 0; i < document_ids_.size(); ++i) {
+        if (term_freqs_[i] != removed_mark_) {
+            document_ids_[kept] = new_ids[document_ids_[i]];
+            term_freqs_[kept] = term_freqs_[i];
+            max_term_freq_ = max(max_term_freq_, term_freqs_[i]);
+            ++kept;
+        }
+    }
+    document_ids_.resize(kept);
+    term_freqs_.resize(kept);
+    removed_count_ = 0;
+}
+
+bool PostingList::Contains(int document_id) const {
+    const size_t position = FindPosition(document_id);
+    return position < document_ids_.size() && document_ids_[position] == document_id
+            && term_freqs_[position] != removed_mark_;
+}
+
+size_t PostingList::size() const {
+    return document_ids_.size() - removed_count_;
+}
+
+bool PostingList::empty() const {
+    return size() == 0;
+}
+
+float PostingList::GetMaxTermFreq() const {
+    return max_term_freq_;
+}
+
+size_t PostingList::FindPosition(int document_id) const {
+    return lower_bound(document_ids_.begin(), document_ids_.end(), document_id) - document_ids_.begin();
+}
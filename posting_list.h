@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Список вхождений термина: отсортированные номера документов и частоты термина
+// лежат в двух непрерывных массивах. Удалённые вхождения помечаются и
+// физически вычищаются, когда их накапливается больше половины списка.
+class PostingList {
+public:
+    // Курсор для обхода списка по возрастанию id с пропуском удалённых вхождений
+    class Cursor {
+    public:
+        explicit Cursor(const PostingList& postings);
+        bool AtEnd() const;
+        int GetDocumentId() const;
+        float GetTermFreq() const;
+        void Next();
+        // Переходит к первому вхождению с id >= document_id
+        void SeekTo(int document_id);
+
+    private:
+        void SkipRemoved();
+
+        const PostingList* postings_;
+        size_t position_ = 0;
+    };
+
+    void Add(int document_id, float term_freq);
+    bool Remove(int document_id);
+    // Помечает вхождение удалённым, не запуская уплотнение: для пакетного удаления
+    bool MarkRemoved(int document_id);
+    void CompactIfSparse();
+    void Compact();
+    // Уплотняет список и заменяет каждый id на new_ids[id]. Отображение должно сохранять порядок
+    // живых вхождений; удалённые вхождения отбрасываются
+    void Renumber(const std::vector<int>& new_ids);
+    bool Contains(int document_id) const;
+
+    size_t size() const;
+    bool empty() const;
+    // Верхняя граница частоты термина в списке: после удалений может быть завышена до уплотнения
+    float GetMaxTermFreq() const;
+
+    template <typename Func>
+    void ForEach(Func func) const {
+        for (size_t i = 0; i < document_ids_.size(); ++i) {
+            if (term_freqs_[i] != removed_mark_) {
+                func(document_ids_[i], term_freqs_[i]);
+            }
+        }
+    }
+
+private:
+    size_t FindPosition(int document_id) const;
+
+    std::vector<int> document_ids_;
+    std::vector<float> term_freqs_;
+    size_t removed_count_ = 0;
+    float max_term_freq_ = 0.0f;
+    // Частота термина в документе всегда положительна, поэтому отрицательное значение свободно для метки
+    static constexpr float removed_mark_ = -1.0f;
+};
@@ -0,0 +1,25 @@
+#include "process_queries.h"
+
+#include <algorithm>
+#include <execution>
+#include <numeric>
+
+using namespace std;
+
+size_t JoinedDocuments::size() const {
+    return transform_reduce(results_.begin(), results_.end(), size_t{0}, plus<>{},
+                            [](const vector<Document>& documents) { return documents.size(); });
+}
+
+vector<vector<Document>> ProcessQueries(const SearchServer& search_server, const vector<string>& queries) {
+    vector<vector<Document>> results(queries.size());
+    transform(execution::par, queries.begin(), queries.end(), results.begin(),
+              [&search_server](const string& query) {
+                  return search_server.FindTopDocuments(query);
+              });
+    return results;
+}
+
+JoinedDocuments ProcessQueriesJoined(const SearchServer& search_server, const vector<string>& queries) {
+    return JoinedDocuments(ProcessQueries(search_server, queries));
+}
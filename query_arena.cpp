@@ -0,0 +1,83 @@
+#include "query_arena.h"
+
+#include <algorithm>
+#include <optional>
+#include <vector>
+
+using namespace std;
+
+static const size_t INITIAL_CAPACITY = 64 * 1024;
+static const size_t MAX_CAPACITY = 64 * 1024 * 1024;
+
+// Выделяет память у кучи и запоминает объём: так видно, что буфера арены не хватило
+class OverflowResource : public pmr::memory_resource {
+public:
+    size_t GetAllocatedBytes() const {
+        return allocated_bytes_;
+    }
+    void Reset() {
+        allocated_bytes_ = 0;
+    }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        allocated_bytes_ += bytes;
+        return pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+        pmr::new_delete_resource()->deallocate(ptr, bytes, alignment);
+    }
+    bool do_is_equal(const pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    size_t allocated_bytes_ = 0;
+};
+
+struct ArenaState {
+    ArenaState()
+        : buffer(INITIAL_CAPACITY) {
+        resource.emplace(buffer.data(), buffer.size(), &overflow);
+    }
+
+    vector<byte> buffer;
+    OverflowResource overflow;
+    optional<pmr::monotonic_buffer_resource> resource;
+    int depth = 0;
+};
+
+static ArenaState& GetArenaState() {
+    static thread_local ArenaState state;
+    return state;
+}
+
+QueryArena::QueryArena() {
+    ArenaState& state = GetArenaState();
+    ++state.depth;
+    resource_ = &*state.resource;
+}
+
+QueryArena::~QueryArena() {
+    ArenaState& state = GetArenaState();
+    if (--state.depth > 0) {
+        return;
+    }
+    const size_t overflow_bytes = state.overflow.GetAllocatedBytes();
+    if (overflow_bytes == 0 || state.buffer.size() == MAX_CAPACITY) {
+        state.resource->release();
+        state.overflow.Reset();
+        return;
+    }
+    state.resource.reset();
+    state.overflow.Reset();
+    state.buffer = vector<byte>(min(MAX_CAPACITY, 2 * (state.buffer.size() + overflow_bytes)));
+    state.resource.emplace(state.buffer.data(), state.buffer.size(), &state.overflow);
+}
+
+pmr::memory_resource* QueryArena::GetResource() const {
+    return resource_;
+}
+
+size_t QueryArena::GetCapacity() {
+    return GetArenaState().buffer.size();
+}
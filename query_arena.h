@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+// Память для временных структур одной операции (разбор запроса, накопление релевантности, частоты слов
+// добавляемого документа). Выделение только сдвигает указатель в буфере своего потока, а вся память
+// возвращается разом, когда завершается самая внешняя операция. Если буфера не хватило, к следующей
+// операции он увеличивается, так что в установившемся режиме операции не обращаются к malloc.
+// Вложенные арены одного потока пользуются общим буфером.
+class QueryArena {
+public:
+    QueryArena();
+    QueryArena(const QueryArena&) = delete;
+    QueryArena& operator=(const QueryArena&) = delete;
+    ~QueryArena();
+
+    std::pmr::memory_resource* GetResource() const;
+    // Размер буфера арены текущего потока
+    static size_t GetCapacity();
+
+private:
+    std::pmr::memory_resource* resource_;
+};
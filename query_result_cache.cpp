@@ -0,0 +1,116 @@
+#include "query_result_cache.h"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+using namespace std;
+
+double QueryResultCache::Stats::GetHitRate() const {
+    const size_t request_count = hit_count + miss_count;
+    return request_count == 0 ? 0.0 : hit_count * 1.0 / request_count;
+}
+
+QueryResultCache::QueryResultCache(const SearchServer& search_server, size_t capacity, size_t shard_count)
+    : search_server_(search_server) {
+    if (capacity == 0 || shard_count == 0) {
+        throw invalid_argument("cache capacity and shard count must be positive"s);
+    }
+    shard_count = min(shard_count, capacity);
+    shard_capacity_ = (capacity + shard_count - 1) / shard_count;
+    shards_.reserve(shard_count);
+    for (size_t i = 0; i < shard_count; ++i) {
+        shards_.push_back(make_unique<Shard>());
+    }
+}
+
+vector<Document> QueryResultCache::FindTopDocuments(string_view raw_query, DocumentStatus status, size_t max_result_count) {
+    return FindCached(MakeKey(raw_query, STATUS_KEY, static_cast<int>(status), max_result_count), [&] {
+        return search_server_.FindTopDocuments(raw_query, status, max_result_count);
+    });
+}
+
+QueryResultCache::Stats QueryResultCache::GetStats() const {
+    Stats stats;
+    stats.hit_count = hit_count_;
+    stats.miss_count = miss_count_;
+    stats.stale_count = stale_count_;
+    stats.hit_latency_us = stats.hit_count == 0 ? 0.0 : hit_nanoseconds_ / 1000.0 / stats.hit_count;
+    stats.miss_latency_us = stats.miss_count == 0 ? 0.0 : miss_nanoseconds_ / 1000.0 / stats.miss_count;
+    return stats;
+}
+
+void QueryResultCache::ResetStats() {
+    hit_count_ = 0;
+    miss_count_ = 0;
+    stale_count_ = 0;
+    hit_nanoseconds_ = 0;
+    miss_nanoseconds_ = 0;
+}
+
+size_t QueryResultCache::size() const {
+    size_t entry_count = 0;
+    for (const auto& shard : shards_) {
+        lock_guard guard(shard->mutex);
+        entry_count += shard->entries.size();
+    }
+    return entry_count;
+}
+
+string QueryResultCache::MakeKey(string_view raw_query, char kind, int selector, size_t max_result_count) const {
+    string key = search_server_.GetQueryKey(raw_query);
+    key.push_back(kind);
+    key.append(reinterpret_cast<const char*>(&selector), sizeof(selector));
+    key.append(reinterpret_cast<const char*>(&max_result_count), sizeof(max_result_count));
+    return key;
+}
+
+QueryResultCache::Shard& QueryResultCache::GetShard(const string& key) {
+    return *shards_[hash<string>{}(key) % shards_.size()];
+}
+
+bool QueryResultCache::Lookup(const string& key, uint64_t version, vector<Document>& documents) {
+    Shard& shard = GetShard(key);
+    lock_guard guard(shard.mutex);
+    const auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        return false;
+    }
+    if (it->second->version != version) {
+        ++stale_count_;
+        shard.entries.erase(it->second);
+        shard.index.erase(it);
+        return false;
+    }
+    shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+    documents = it->second->documents;
+    return true;
+}
+
+void QueryResultCache::Store(string key, uint64_t version, const vector<Document>& documents) {
+    Shard& shard = GetShard(key);
+    lock_guard guard(shard.mutex);
+    // Пока результат вычислялся, тот же запрос мог сохранить другой поток
+    const auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        shard.entries.erase(it->second);
+        shard.index.erase(it);
+    }
+    shard.entries.push_front({move(key), version, documents});
+    shard.index.emplace(shard.entries.front().key, shard.entries.begin());
+    if (shard.entries.size() > shard_capacity_) {
+        shard.index.erase(shard.entries.back().key);
+        shard.entries.pop_back();
+    }
+}
+
+void QueryResultCache::RecordLatency(bool is_hit, chrono::steady_clock::time_point start) {
+    const uint64_t nanoseconds = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    if (is_hit) {
+        ++hit_count_;
+        hit_nanoseconds_ += nanoseconds;
+    } else {
+        ++miss_count_;
+        miss_nanoseconds_ += nanoseconds;
+    }
+}
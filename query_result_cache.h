@@ -0,0 +1,98 @@
+#pragma once
+
+#include "search_server.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Кэш результатов FindTopDocuments перед SearchServer. Ключ - нормализованный запрос
+// (SearchServer::GetQueryKey), статус или id предиката и число результатов. Каждый результат
+// помечен версией индекса, при которой получен: после AddDocument или RemoveDocument
+// он перестаёт совпадать с версией сервера и вычисляется заново.
+// Кэш разбит на шарды со своими мьютексами и вытеснением давно не использованных результатов.
+// Из нескольких потоков кэш можно читать, пока сервер не меняется, как и сам SearchServer.
+class QueryResultCache {
+public:
+    struct Stats {
+        size_t hit_count = 0;
+        size_t miss_count = 0;
+        // Промахи, при которых результат был, но устарел из-за изменения индекса
+        size_t stale_count = 0;
+        // Среднее время ответа в микросекундах
+        double hit_latency_us = 0.0;
+        double miss_latency_us = 0.0;
+
+        double GetHitRate() const;
+    };
+
+    explicit QueryResultCache(const SearchServer& search_server, size_t capacity = 10000, size_t shard_count = 16);
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status = DocumentStatus::ACTUAL,
+                                           size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT);
+    // Предикаты нельзя сравнить, поэтому вызывающий сам задаёт predicate_id:
+    // одинаковый id должен означать одинаковый отбор документов
+    template <typename KeyMapper>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, int predicate_id, const KeyMapper& key_mapper,
+                                           size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) {
+        return FindCached(MakeKey(raw_query, PREDICATE_KEY, predicate_id, max_result_count), [&] {
+            return search_server_.FindTopDocuments(raw_query, key_mapper, max_result_count);
+        });
+    }
+
+    Stats GetStats() const;
+    void ResetStats();
+    size_t size() const;
+
+private:
+    struct Entry {
+        std::string key;
+        uint64_t version;
+        std::vector<Document> documents;
+    };
+    // Последний использованный результат - в начале списка
+    struct Shard {
+        mutable std::mutex mutex;
+        std::list<Entry> entries;
+        std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+    };
+    static const char STATUS_KEY = 'S';
+    static const char PREDICATE_KEY = 'P';
+
+    std::string MakeKey(std::string_view raw_query, char kind, int selector, size_t max_result_count) const;
+    Shard& GetShard(const std::string& key);
+    bool Lookup(const std::string& key, uint64_t version, std::vector<Document>& documents);
+    void Store(std::string key, uint64_t version, const std::vector<Document>& documents);
+    void RecordLatency(bool is_hit, std::chrono::steady_clock::time_point start);
+
+    template <typename Search>
+    std::vector<Document> FindCached(std::string key, const Search& search) {
+        const auto start = std::chrono::steady_clock::now();
+        const uint64_t version = search_server_.GetVersion();
+        std::vector<Document> documents;
+        if (Lookup(key, version, documents)) {
+            RecordLatency(true, start);
+            return documents;
+        }
+        documents = search();
+        Store(std::move(key), version, documents);
+        RecordLatency(false, start);
+        return documents;
+    }
+
+    const SearchServer& search_server_;
+    size_t shard_capacity_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<size_t> hit_count_ = 0;
+    std::atomic<size_t> miss_count_ = 0;
+    std::atomic<size_t> stale_count_ = 0;
+    std::atomic<uint64_t> hit_nanoseconds_ = 0;
+    std::atomic<uint64_t> miss_nanoseconds_ = 0;
+};
@@ -0,0 +1,71 @@
+#include "relevance_accumulator.h"
+
+#include <algorithm>
+
+using namespace std;
+
+// Плотный массив выгоден, пока на каждое вхождение приходится немного ячеек массива:
+// обнуление и просмотр маски стоят дешевле вставок в хеш-таблицу и сортировки результата
+static const size_t DENSE_SLOTS_PER_POSTING = 128;
+
+RelevanceAccumulator::Strategy RelevanceAccumulator::ChooseStrategy(size_t document_id_bound, size_t posting_count) {
+    return document_id_bound <= posting_count * DENSE_SLOTS_PER_POSTING ? Strategy::DENSE : Strategy::HASH;
+}
+
+RelevanceAccumulator::RelevanceAccumulator(size_t document_id_bound, size_t posting_count, pmr::memory_resource* resource)
+    : RelevanceAccumulator(ChooseStrategy(document_id_bound, posting_count), document_id_bound, posting_count, resource) {
+}
+
+RelevanceAccumulator::RelevanceAccumulator(Strategy strategy, size_t document_id_bound, size_t posting_count,
+                                           pmr::memory_resource* resource)
+    : strategy_(strategy)
+    , scores_(resource)
+    , touched_(resource)
+    , slots_(resource) {
+    if (strategy_ == Strategy::DENSE) {
+        scores_.resize(document_id_bound);
+        touched_.resize((document_id_bound + 63) / 64);
+    } else {
+        // Заполнение не больше половины: различных документов не больше, чем вхождений
+        size_t capacity = 16;
+        hash_shift_ = 60;
+        while (capacity < posting_count * 2) {
+            capacity *= 2;
+            --hash_shift_;
+        }
+        slots_.resize(capacity);
+    }
+}
+
+void RelevanceAccumulator::Exclude(int document_id) {
+    if (strategy_ == Strategy::DENSE) {
+        if (static_cast<size_t>(document_id) < scores_.size()) {
+            touched_[document_id / 64] &= ~(uint64_t{1} << (document_id % 64));
+        }
+        return;
+    }
+    Slot& slot = FindSlot(document_id);
+    if (slot.document_id == document_id) {
+        slot.is_excluded = true;
+    }
+}
+
+pmr::vector<pair<int, double>> RelevanceAccumulator::Extract() const {
+    pmr::vector<pair<int, double>> documents(scores_.get_allocator());
+    if (strategy_ == Strategy::DENSE) {
+        for (size_t word_index = 0; word_index < touched_.size(); ++word_index) {
+            for (uint64_t word = touched_[word_index]; word != 0; word &= word - 1) {
+                const int document_id = static_cast<int>(word_index * 64 + __builtin_ctzll(word));
+                documents.emplace_back(document_id, scores_[document_id]);
+            }
+        }
+        return documents;
+    }
+    for (const Slot& slot : slots_) {
+        if (slot.document_id != EMPTY_SLOT && !slot.is_excluded) {
+            documents.emplace_back(slot.document_id, slot.relevance);
+        }
+    }
+    sort(documents.begin(), documents.end());
+    return documents;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+// Накопитель релевантности документов для одного запроса. Два способа хранения:
+// плотный массив по document_id с битовой маской затронутых документов, когда id плотные
+// и запрос затрагивает заметную часть коллекции, и хеш-таблица с открытой адресацией,
+// когда вхождений мало по сравнению с диапазоном id. Документы минус-слов снимаются с маски.
+// Вся память берётся из переданного ресурса, обычно из арены запроса.
+class RelevanceAccumulator {
+public:
+    enum class Strategy {
+        DENSE,
+        HASH
+    };
+
+    // document_id_bound больше любого id в индексе, posting_count - суммарная длина списков плюс-слов
+    static Strategy ChooseStrategy(size_t document_id_bound, size_t posting_count);
+
+    RelevanceAccumulator(size_t document_id_bound, size_t posting_count, std::pmr::memory_resource* resource);
+    RelevanceAccumulator(Strategy strategy, size_t document_id_bound, size_t posting_count, std::pmr::memory_resource* resource);
+
+    Strategy GetStrategy() const {
+        return strategy_;
+    }
+
+    void Add(int document_id, double relevance) {
+        if (strategy_ == Strategy::DENSE) {
+            scores_[document_id] += relevance;
+            touched_[document_id / 64] |= uint64_t{1} << (document_id % 64);
+        } else {
+            Slot& slot = FindSlot(document_id);
+            slot.document_id = document_id;
+            slot.relevance += relevance;
+        }
+    }
+
+    void Exclude(int document_id);
+
+    // Найденные документы по возрастанию id, без исключённых
+    std::pmr::vector<std::pair<int, double>> Extract() const;
+
+private:
+    struct Slot {
+        int document_id = EMPTY_SLOT;
+        bool is_excluded = false;
+        double relevance = 0.0;
+    };
+    static constexpr int EMPTY_SLOT = -1;
+
+    Slot& FindSlot(int document_id) {
+        size_t index = (static_cast<uint64_t>(document_id) * 0x9E3779B97F4A7C15ull) >> hash_shift_;
+        while (slots_[index].document_id != document_id && slots_[index].document_id != EMPTY_SLOT) {
+            index = (index + 1) & (slots_.size() - 1);
+        }
+        return slots_[index];
+    }
+
+    Strategy strategy_;
+    std::pmr::vector<double> scores_;
+    std::pmr::vector<uint64_t> touched_;
+    std::pmr::vector<Slot> slots_;
+    int hash_shift_ = 64;
+};
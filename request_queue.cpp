@@ -1,29 +1,88 @@
 #include "request_queue.h"
 
 #include <algorithm>
+#include <cmath>
+#include <stdexcept>
 
 using namespace std;
 
+static const uint64_t LATENCY_BUCKET_MASK = 0x7f;
+static const uint64_t NO_RESULT_FLAG = 0x80;
+static const int REQUEST_SHIFT = 8;
+
+RequestQueue::RequestQueue(const SearchServer& search_server, size_t window_size)
+    : search_server_(search_server)
+    , summaries_(window_size) {
+    if (window_size == 0) {
+        throw invalid_argument("request window must not be empty"s);
+    }
+}
+
 vector<Document> RequestQueue::AddFindRequest(const string& raw_query, DocumentStatus status) {
-    return ProcessQeque(raw_query,search_server_.FindTopDocuments(raw_query, status));
+    const auto start = chrono::steady_clock::now();
+    vector<Document> result = search_server_.FindTopDocuments(raw_query, status);
+    Record(result.empty(), start);
+    return result;
 }
 
 vector<Document> RequestQueue::AddFindRequest(const string& raw_query) {
-    return ProcessQeque(raw_query,search_server_.FindTopDocuments(raw_query));
+    return AddFindRequest(raw_query, DocumentStatus::ACTUAL);
 }
 
 int RequestQueue::GetNoResultRequests() const {
-    return count_if(requests_.begin(),requests_.end(),[](const QueryResult& r){return r.isNoResult;});
+    return no_result_count_.load(memory_order_relaxed);
+}
+
+int RequestQueue::GetHitRequests() const {
+    return GetRequestCount() - GetNoResultRequests();
+}
+
+int RequestQueue::GetRequestCount() const {
+    return request_count_.load(memory_order_relaxed);
+}
+
+double RequestQueue::GetLatencyPercentile(double quantile) const {
+    const int request_count = GetRequestCount();
+    if (request_count <= 0) {
+        return 0.0;
+    }
+    const int rank = max(1, static_cast<int>(ceil(clamp(quantile, 0.0, 1.0) * request_count)));
+    int passed_count = 0;
+    int bucket = 0;
+    for (; bucket < LATENCY_BUCKET_COUNT - 1; ++bucket) {
+        passed_count += latency_histogram_[bucket].load(memory_order_relaxed);
+        if (passed_count >= rank) {
+            break;
+        }
+    }
+    return GetLatencyBucketBound(bucket) / 1000.0;
+}
+
+// Сводка запроса занимает ячейку, если в ней нет более нового запроса. Иначе запрос уже
+// вытеснен из окна и не учитывается. Счётчики увеличиваются до записи сводки, поэтому
+// вытеснивший её поток не может уменьшить их раньше
+void RequestQueue::Record(bool is_no_result, chrono::steady_clock::time_point start) {
+    const uint64_t latency_ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    const uint64_t request = next_request_.fetch_add(1, memory_order_relaxed);
+    const uint64_t summary = ((request + 1) << REQUEST_SHIFT) | (is_no_result ? NO_RESULT_FLAG : 0) | GetLatencyBucket(latency_ns);
+    Count(summary, 1);
+    atomic<uint64_t>& slot = summaries_[request % summaries_.size()];
+    uint64_t evicted = slot.load(memory_order_relaxed);
+    do {
+        if (evicted > summary) {
+            Count(summary, -1);
+            return;
+        }
+    } while (!slot.compare_exchange_weak(evicted, summary, memory_order_relaxed));
+    if (evicted != 0) {
+        Count(evicted, -1);
+    }
 }
 
-vector<Document> RequestQueue::ProcessQeque(const string& raw_query, vector<Document> result) {
-    QueryResult r;
-    r.raw_query = raw_query;
-    r.result = result;
-    r.isNoResult = r.result.empty();
-    requests_.push_back(r);
-    if (requests_.size() > sec_in_day_) {
-        requests_.pop_front();
+void RequestQueue::Count(uint64_t summary, int delta) {
+    request_count_.fetch_add(delta, memory_order_relaxed);
+    if (summary & NO_RESULT_FLAG) {
+        no_result_count_.fetch_add(delta, memory_order_relaxed);
     }
-    return r.result;
+    latency_histogram_[summary & LATENCY_BUCKET_MASK].fetch_add(delta, memory_order_relaxed);
 }
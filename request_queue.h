@@ -1,34 +1,52 @@
 #pragma once
 
 #include "search_server.h"
+#include "metrics.h"
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <vector>
 #include <string>
-#include <queue>
 
+// Статистика последних window_size запросов (по умолчанию - сутки по запросу в минуту).
+// Запросы можно добавлять из нескольких потоков без блокировок: каждый запрос хранится
+// в кольцевом буфере как 64-битная сводка (номер запроса, пустой ли результат, интервал
+// времени ответа), а счётчики окна обновляются атомарно при вытеснении сводок,
+// поэтому вся статистика читается за O(1)
 class RequestQueue {
 public:
-    explicit RequestQueue(const SearchServer& search_server):
-        search_server_(search_server)    {
-    }
+    explicit RequestQueue(const SearchServer& search_server, size_t window_size = MIN_IN_DAY);
 
     template <typename DocumentPredicate>
     std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate) {
-        return ProcessQeque(raw_query,search_server_.FindTopDocuments(raw_query,document_predicate));
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<Document> result = search_server_.FindTopDocuments(raw_query, document_predicate);
+        Record(result.empty(), start);
+        return result;
     }
     std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentStatus status);
     std::vector<Document> AddFindRequest(const std::string& raw_query);
     int GetNoResultRequests() const;
+    // Запросы окна, нашедшие хотя бы один документ
+    int GetHitRequests() const;
+    int GetRequestCount() const;
+    // Время ответа в микросекундах, которого не превышает доля quantile запросов окна.
+    // Точность - интервал гистограммы GetLatencyBucket, четверть степени двойки
+    double GetLatencyPercentile(double quantile) const;
 
 private:
-    struct QueryResult {
-        std::string raw_query;
-        std::vector<Document> result;
-        bool isNoResult;
-    };
-    std::vector<Document> ProcessQeque(const std::string& raw_query, std::vector<Document> result);
+    static const size_t MIN_IN_DAY = 1440;
+
+    void Record(bool is_no_result, std::chrono::steady_clock::time_point start);
+    void Count(uint64_t summary, int delta);
 
-    std::deque<QueryResult> requests_;
-    const static int sec_in_day_ = 1440;
     const SearchServer& search_server_;
+    // Сводка: номер запроса + 1 в старших битах (0 - ячейка пуста), признак пустого результата, интервал времени ответа
+    std::vector<std::atomic<uint64_t>> summaries_;
+    std::atomic<uint64_t> next_request_ = 0;
+    std::atomic<int> request_count_ = 0;
+    std::atomic<int> no_result_count_ = 0;
+    std::array<std::atomic<int>, LATENCY_BUCKET_COUNT> latency_histogram_{};
 };
@@ -1,15 +1,17 @@
 #include "search_server.h"
+#include "duplicate_detector.h"
 #include "string_processing.h"
 
 #include <iostream>
 #include <algorithm>
 #include <numeric>
 #include <cmath>
+#include <atomic>
 
 
 using namespace std;
 
-const map<string, double> SearchServer::empty_word_freqs_ = map<string, double>();
+static thread_local SearchServer::QueryStats last_query_stats;
 
 int SecureSum(int sum, int x) {
     if ( (sum < 0) && (x < 0) && (numeric_limits<int>::min() - x > sum)) {
@@ -23,106 +25,521 @@ int SecureSum(int sum, int x) {
     }
 }
 
+StatusFilter::StatusFilter(DocumentStatus status)
+    : mask_(1u << static_cast<int>(status)) {
+}
+
+StatusFilter::StatusFilter(initializer_list<DocumentStatus> statuses)
+    : mask_(0) {
+    for (const DocumentStatus status : statuses) {
+        mask_ |= 1u << static_cast<int>(status);
+    }
+}
+
+bool StatusFilter::Contains(DocumentStatus status) const {
+    return (mask_ >> static_cast<int>(status)) & 1;
+}
+
+bool StatusFilter::ContainsAll() const {
+    return mask_ == (1u << DOCUMENT_STATUS_COUNT) - 1;
+}
+
 SearchServer::SearchServer(const string& stop_words_text)
+    : SearchServer(string_view(stop_words_text)) {
+}
+
+SearchServer::SearchServer(string_view stop_words_text)
     : SearchServer(SplitIntoWords(stop_words_text)) {
 }
 
+SearchServer::SearchServer(const SearchServer& other) {
+    AssignIndex(other);
+}
+
+SearchServer& SearchServer::operator=(const SearchServer& other) {
+    if (this != &other) {
+        AssignIndex(other);
+    }
+    return *this;
+}
+
+// Пул остаётся прежним: узлы, выделенные в нём, освобождаются раньше, чем он сам
+SearchServer& SearchServer::operator=(SearchServer&& other) {
+    if (this != &other) {
+        AssignIndex(move(other));
+    }
+    return *this;
+}
+
+// Аллокаторы pmr не переходят при присваивании, поэтому контейнеры остаются в пуле
+// этого сервера, а элементы копируются в него. Версия растёт, чтобы кэши результатов,
+// привязанные к этому серверу, не приняли новое содержимое за старое
+template <typename Source>
+void SearchServer::AssignIndex(Source&& other) {
+    document_to_ordinal_ = forward<Source>(other).document_to_ordinal_;
+    document_ids_ = forward<Source>(other).document_ids_;
+    ordinal_to_document_ = forward<Source>(other).ordinal_to_document_;
+    ratings_ = forward<Source>(other).ratings_;
+    statuses_ = forward<Source>(other).statuses_;
+    document_term_freqs_.clear();
+    document_term_freqs_.reserve(other.document_term_freqs_.size());
+    for (const TermFreqs& term_freqs : other.document_term_freqs_) {
+        document_term_freqs_.emplace_back(term_freqs, index_resource_.get());
+    }
+    free_ordinal_count_ = other.free_ordinal_count_;
+    status_bitmaps_ = forward<Source>(other).status_bitmaps_;
+    stop_words_ = forward<Source>(other).stop_words_;
+    terms_ = forward<Source>(other).terms_;
+    term_to_document_freqs_ = forward<Source>(other).term_to_document_freqs_;
+    idf_cache_ = forward<Source>(other).idf_cache_;
+    query_evaluation_ = other.query_evaluation_;
+    duplicate_policy_ = other.duplicate_policy_;
+    fingerprint_to_ordinals_ = forward<Source>(other).fingerprint_to_ordinals_;
+    version_ = max(version_, other.version_) + 1;
+}
+
 int SearchServer::GetDocumentCount() const{
-    return documents_.size();
+    return document_ids_.size();
+}
+
+bool SearchServer::HasDocument(int document_id) const {
+    return document_to_ordinal_.count(document_id) > 0;
+}
+
+uint64_t SearchServer::GetVersion() const {
+    return version_;
+}
+
+string SearchServer::GetQueryKey(string_view raw_query) const {
+    QueryArena arena;
+    const Query query = ParseQuery(raw_query, arena.GetResource());
+    string key;
+    key.reserve((query.plus_terms.size() + query.minus_terms.size() + 1) * sizeof(TermId));
+    const auto append_term = [&key](TermId term_id) {
+        key.append(reinterpret_cast<const char*>(&term_id), sizeof(term_id));
+    };
+    for_each(query.plus_terms.begin(), query.plus_terms.end(), append_term);
+    append_term(UNKNOWN_TERM);
+    for_each(query.minus_terms.begin(), query.minus_terms.end(), append_term);
+    return key;
+}
+
+const set<string, less<>>& SearchServer::GetStopWords() const {
+    return stop_words_;
+}
+
+void SearchServer::SetQueryEvaluation(QueryEvaluation query_evaluation) {
+    query_evaluation_ = query_evaluation;
+}
+
+void SearchServer::SetIdfMaxDrift(double max_drift) {
+    idf_cache_.SetMaxDrift(max_drift);
+    ++version_;
+}
+
+SearchServer::QueryStats SearchServer::GetLastQueryStats() {
+    return last_query_stats;
+}
+
+SearchServer::CorpusStats& SearchServer::CorpusStats::operator+=(const CorpusStats& other) {
+    document_count += other.document_count;
+    for (const auto& [word, document_freq] : other.document_freqs) {
+        document_freqs[word] += document_freq;
+    }
+    return *this;
+}
+
+SearchServer::CorpusStats& SearchServer::CorpusStats::operator-=(const CorpusStats& other) {
+    document_count -= other.document_count;
+    for (auto& [word, document_freq] : document_freqs) {
+        const auto other_it = other.document_freqs.find(word);
+        if (other_it != other.document_freqs.end()) {
+            document_freq -= other_it->second;
+        }
+    }
+    return *this;
+}
+
+SearchServer::CorpusStats SearchServer::GetCorpusStats(string_view raw_query) const {
+    CorpusStats corpus_stats;
+    corpus_stats.document_count = document_ids_.size();
+    QueryArena arena;
+    for (const TermId term_id : ParseQuery(raw_query, arena.GetResource()).plus_terms) {
+        corpus_stats.document_freqs.emplace(terms_.GetTerm(term_id), term_to_document_freqs_[term_id].size());
+    }
+    return corpus_stats;
 }
 
-const map<string, double>& SearchServer::GetWordFrequencies(int document_id) const {
-    return (documents_.count(document_id)!=0 ?documents_.at(document_id).word_to_freqs:empty_word_freqs_);
+map<string_view, double> SearchServer::GetWordFrequencies(int document_id) const {
+    map<string_view, double> word_freqs;
+    const auto ordinal_it = document_to_ordinal_.find(document_id);
+    if (ordinal_it != document_to_ordinal_.end()) {
+        for (const auto& [term_id, term_freq] : document_term_freqs_[ordinal_it->second]) {
+            word_freqs.emplace(terms_.GetTerm(term_id), term_freq);
+        }
+    }
+    return word_freqs;
 }
 
-void SearchServer::AddDocument(int document_id, const string& document, DocumentStatus status, const vector<int>& ratings) {
+void SearchServer::AddDocument(int document_id, string_view document, DocumentStatus status, const vector<int>& ratings) {
+    MetricTimer timer(MetricStage::ADD_DOCUMENT);
     if (document_id < 0) {
         throw invalid_argument("document_id < 0"s);
     }
-    if (documents_.count(document_id) > 0) {
+    if (document_to_ordinal_.count(document_id) > 0) {
         throw invalid_argument("document already exists"s);
     }
-    const vector<string> words = SplitIntoWordsNoStop(document);
+    QueryArena arena;
+    const vector<string_view> words = SplitIntoWordsNoStop(document);
     const double inv_word_count = 1.0 / words.size();
-    map<string,double> word_to_freq;
-    for (const string& word : words) {
-        if (word_to_document_freqs_[word].count(document_id) == 0) {
-            word_to_document_freqs_[word][document_id] = 0;
+    pmr::map<TermId, double> term_to_freq(arena.GetResource());
+    for (const string_view word : words) {
+        term_to_freq[terms_.Intern(word)] += inv_word_count;
+    }
+    if (term_to_document_freqs_.size() < terms_.size()) {
+        term_to_document_freqs_.resize(terms_.size());
+    }
+    TermFreqs term_freqs(index_resource_.get());
+    term_freqs.reserve(term_to_freq.size());
+    for (const auto [term_id, term_freq] : term_to_freq) {
+        term_freqs.emplace_back(term_id, static_cast<float>(term_freq));
+    }
+    if (duplicate_policy_ == DuplicatePolicy::REJECT) {
+        const vector<int> duplicate_ids = FindDuplicateIds(term_freqs);
+        if (!duplicate_ids.empty() && duplicate_ids.front() < document_id) {
+            throw invalid_argument("document duplicates document "s + to_string(duplicate_ids.front()));
         }
-        word_to_document_freqs_[word][document_id] += inv_word_count;
-        if (word_to_freq.count(word) == 0) {
-            word_to_freq[word] = 0;
+        // Дубликаты с большим id вытесняются, как при RemoveDuplicates
+        for (const int duplicate_id : duplicate_ids) {
+            RemoveDocument(duplicate_id);
         }
-        word_to_freq[word] += inv_word_count;
     }
-    documents_.emplace(document_id, DocumentData{ComputeAverageRating(ratings), status, word_to_freq});
-    document_ids_.push_back(document_id);
+    const int ordinal = AllocateOrdinal(document_id, ComputeAverageRating(ratings), status, move(term_freqs));
+    for (const auto& [term_id, term_freq] : document_term_freqs_[ordinal]) {
+        term_to_document_freqs_[term_id].Add(ordinal, term_freq);
+    }
 }
 
-void SearchServer::RemoveDocument(int document_id) {
-    auto it = find(document_ids_.begin(),document_ids_.end(),document_id);
-    if (it==document_ids_.end()) {
-        return;
+void SearchServer::SetDuplicatePolicy(DuplicatePolicy duplicate_policy) {
+    const bool was_indexed = duplicate_policy_ != DuplicatePolicy::ALLOW;
+    duplicate_policy_ = duplicate_policy;
+    if (duplicate_policy == DuplicatePolicy::ALLOW) {
+        fingerprint_to_ordinals_.clear();
+    } else if (!was_indexed) {
+        fingerprint_to_ordinals_.reserve(document_to_ordinal_.size());
+        for (const auto& [document_id, ordinal] : document_to_ordinal_) {
+            IndexFingerprint(ordinal);
+        }
     }
-    document_ids_.erase(it);
-    vector<string> words_for_remove;
-    for (auto& [word, document_freqs] :  word_to_document_freqs_) {
-        document_freqs.erase(document_id);
-        if (document_freqs.size()==0) {
-            words_for_remove.push_back(word);
+}
+
+int SearchServer::GetOriginalId(int document_id) const {
+    if (duplicate_policy_ == DuplicatePolicy::ALLOW) {
+        throw logic_error("duplicate tracking is disabled"s);
+    }
+    return FindDuplicateIds(document_term_freqs_[document_to_ordinal_.at(document_id)]).front();
+}
+
+Fingerprint SearchServer::ComputeFingerprint(const TermFreqs& term_freqs) {
+    Fingerprint fingerprint;
+    for (const auto& [term_id, term_freq] : term_freqs) {
+        fingerprint.Add(term_id);
+    }
+    return fingerprint;
+}
+
+bool SearchServer::HaveSameTerms(const TermFreqs& lhs, const TermFreqs& rhs) {
+    return equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const auto& lhs_term, const auto& rhs_term) {
+        return lhs_term.first == rhs_term.first;
+    });
+}
+
+// Отпечатки совпадают и у разных множеств, хотя это практически исключено, поэтому множества сравниваются
+vector<int> SearchServer::FindDuplicateIds(const TermFreqs& term_freqs) const {
+    vector<int> duplicate_ids;
+    const auto ordinals_it = fingerprint_to_ordinals_.find(ComputeFingerprint(term_freqs));
+    if (ordinals_it != fingerprint_to_ordinals_.end()) {
+        for (const int ordinal : ordinals_it->second) {
+            if (HaveSameTerms(document_term_freqs_[ordinal], term_freqs)) {
+                duplicate_ids.push_back(ordinal_to_document_[ordinal]);
+            }
         }
     }
-    for (const string& word: words_for_remove) {
-        word_to_document_freqs_.erase(word);
+    sort(duplicate_ids.begin(), duplicate_ids.end());
+    return duplicate_ids;
+}
+
+void SearchServer::IndexFingerprint(int ordinal) {
+    fingerprint_to_ordinals_[ComputeFingerprint(document_term_freqs_[ordinal])].push_back(ordinal);
+}
+
+void SearchServer::UnindexFingerprint(int ordinal) {
+    const auto ordinals_it = fingerprint_to_ordinals_.find(ComputeFingerprint(document_term_freqs_[ordinal]));
+    vector<int>& ordinals = ordinals_it->second;
+    ordinals.erase(find(ordinals.begin(), ordinals.end(), ordinal));
+    if (ordinals.empty()) {
+        fingerprint_to_ordinals_.erase(ordinals_it);
     }
-    documents_.erase(document_id);
 }
 
-vector<Document> SearchServer::FindTopDocuments(const string& raw_query, DocumentStatus status) const{
-#ifdef SHOW_OPERATION_TIME
-    LOG_DURATION_STREAM("Operation time", cout);
-#endif
-    return FindTopDocuments(raw_query, [status]([[maybe_unused]] int document_id, DocumentStatus document_status, [[maybe_unused]] int document_rating)
-            { return document_status == status; });
+// Новый документ всегда получает номер больше всех прежних, поэтому его вхождения дописываются в конец списков
+int SearchServer::AllocateOrdinal(int document_id, int rating, DocumentStatus status, TermFreqs term_freqs) {
+    const int ordinal = static_cast<int>(ordinal_to_document_.size());
+    ordinal_to_document_.push_back(document_id);
+    ratings_.push_back(rating);
+    statuses_.push_back(status);
+    document_term_freqs_.push_back(move(term_freqs));
+    if (ordinal % 64 == 0) {
+        for (vector<uint64_t>& status_bitmap : status_bitmaps_) {
+            status_bitmap.push_back(0);
+        }
+    }
+    status_bitmaps_[static_cast<int>(status)][ordinal / 64] |= uint64_t{1} << (ordinal % 64);
+    document_to_ordinal_.emplace(document_id, ordinal);
+    document_ids_.insert(document_id);
+    idf_cache_.Resize(terms_.size());
+    for (const auto& [term_id, term_freq] : document_term_freqs_[ordinal]) {
+        idf_cache_.Invalidate(term_id);
+    }
+    idf_cache_.SetDocumentCount(document_ids_.size());
+    if (duplicate_policy_ != DuplicatePolicy::ALLOW) {
+        IndexFingerprint(ordinal);
+    }
+    ++version_;
+    return ordinal;
+}
+
+// Вхождения документа к этому моменту уже помечены удалёнными
+void SearchServer::ReleaseOrdinal(int document_id, int ordinal) {
+    if (duplicate_policy_ != DuplicatePolicy::ALLOW) {
+        UnindexFingerprint(ordinal);
+    }
+    ordinal_to_document_[ordinal] = FREE_ORDINAL;
+    status_bitmaps_[static_cast<int>(statuses_[ordinal])][ordinal / 64] &= ~(uint64_t{1} << (ordinal % 64));
+    for (const auto& [term_id, term_freq] : document_term_freqs_[ordinal]) {
+        idf_cache_.Invalidate(term_id);
+    }
+    document_term_freqs_[ordinal] = TermFreqs(index_resource_.get());
+    ++free_ordinal_count_;
+    document_to_ordinal_.erase(document_id);
+    document_ids_.erase(document_id);
+    idf_cache_.SetDocumentCount(document_ids_.size());
+    ++version_;
+    if (free_ordinal_count_ * 2 > ordinal_to_document_.size()) {
+        RenumberOrdinals();
+    }
 }
 
-tuple<vector<string>, DocumentStatus> SearchServer::MatchDocument(const string& raw_query, int document_id) const{
-    const Query query = ParseQuery(raw_query);
-    vector<string> MatchedWords;
-    for (const string& word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
+// Номера живых документов сдвигаются подряд с сохранением порядка, поэтому списки вхождений
+// остаются отсортированными и уплотняются за один проход. Проход стоит O(числа вхождений),
+// но запускается не чаще, чем через половину номеров удалений
+void SearchServer::RenumberOrdinals() {
+    vector<int> new_ordinals(ordinal_to_document_.size(), FREE_ORDINAL);
+    int ordinal_count = 0;
+    for (int ordinal = 0; ordinal < static_cast<int>(ordinal_to_document_.size()); ++ordinal) {
+        if (ordinal_to_document_[ordinal] == FREE_ORDINAL) {
             continue;
         }
-        if ( find_if(word_to_document_freqs_.at(word).begin(), word_to_document_freqs_.at(word).end(),
-                [document_id](const pair<int, double>& p){
-                        return (document_id == p.first);
-                }
-          ) != word_to_document_freqs_.at(word).end() ) {
-                return make_tuple(vector<string>{},documents_.at(document_id).status);
+        new_ordinals[ordinal] = ordinal_count;
+        ordinal_to_document_[ordinal_count] = ordinal_to_document_[ordinal];
+        ratings_[ordinal_count] = ratings_[ordinal];
+        statuses_[ordinal_count] = statuses_[ordinal];
+        document_term_freqs_[ordinal_count] = move(document_term_freqs_[ordinal]);
+        ++ordinal_count;
+    }
+    ordinal_to_document_.resize(ordinal_count);
+    ratings_.resize(ordinal_count);
+    statuses_.resize(ordinal_count);
+    document_term_freqs_.erase(document_term_freqs_.begin() + ordinal_count, document_term_freqs_.end());
+    for (vector<uint64_t>& status_bitmap : status_bitmaps_) {
+        status_bitmap.assign((ordinal_count + 63) / 64, 0);
+    }
+    for (int ordinal = 0; ordinal < ordinal_count; ++ordinal) {
+        status_bitmaps_[static_cast<int>(statuses_[ordinal])][ordinal / 64] |= uint64_t{1} << (ordinal % 64);
+    }
+    for (auto& [document_id, ordinal] : document_to_ordinal_) {
+        ordinal = new_ordinals[ordinal];
+    }
+    for (PostingList& postings : term_to_document_freqs_) {
+        postings.Renumber(new_ordinals);
+    }
+    for (auto& [fingerprint, ordinals] : fingerprint_to_ordinals_) {
+        for (int& ordinal : ordinals) {
+            ordinal = new_ordinals[ordinal];
         }
+    }
+    free_ordinal_count_ = 0;
+}
 
+void SearchServer::MergeDocuments(const SearchServer& source, const set<int>& skipped_ids) {
+    vector<TermId> term_ids(source.terms_.size(), UNKNOWN_TERM);
+    for (const auto& [document_id, source_ordinal] : source.document_to_ordinal_) {
+        if (skipped_ids.count(document_id) == 0) {
+            MergeDocument(source, document_id, source_ordinal, term_ids);
+        }
     }
-    for (const string& word : query.plus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
+}
+
+void SearchServer::MergeDocuments(const vector<const SearchServer*>& sources) {
+    vector<tuple<int, size_t, int>> source_documents;
+    vector<vector<TermId>> source_term_ids;
+    for (size_t i = 0; i < sources.size(); ++i) {
+        for (const auto& [document_id, source_ordinal] : sources[i]->document_to_ordinal_) {
+            source_documents.emplace_back(document_id, i, source_ordinal);
         }
-        for (const auto [id, term_freq] : word_to_document_freqs_.at(word)) {
-            if ( (id == document_id) && (count(MatchedWords.begin(),MatchedWords.end(),word) == 0) ){
-                MatchedWords.push_back(word);
-            }
+        source_term_ids.emplace_back(sources[i]->terms_.size(), UNKNOWN_TERM);
+    }
+    sort(source_documents.begin(), source_documents.end(), [](const auto& lhs, const auto& rhs) {
+        return get<0>(lhs) < get<0>(rhs);
+    });
+    // Повторы проверяются до слияния, чтобы при ошибке индекс остался прежним
+    for (size_t i = 0; i < source_documents.size(); ++i) {
+        const int document_id = get<0>(source_documents[i]);
+        if (document_to_ordinal_.count(document_id) > 0 || (i > 0 && get<0>(source_documents[i - 1]) == document_id)) {
+            throw invalid_argument("document already exists"s);
+        }
+    }
+    for (const auto& [document_id, source_index, source_ordinal] : source_documents) {
+        MergeDocument(*sources[source_index], document_id, source_ordinal, source_term_ids[source_index]);
+    }
+}
+
+// term_ids - соответствие терминов источника терминам этого сервера, заполняется по мере слияния
+void SearchServer::MergeDocument(const SearchServer& source, int document_id, int source_ordinal, vector<TermId>& term_ids) {
+    if (document_to_ordinal_.count(document_id) > 0) {
+        throw invalid_argument("document already exists"s);
+    }
+    const TermFreqs& source_term_freqs = source.document_term_freqs_[source_ordinal];
+    TermFreqs term_freqs(index_resource_.get());
+    term_freqs.reserve(source_term_freqs.size());
+    for (const auto& [source_term_id, term_freq] : source_term_freqs) {
+        TermId& term_id = term_ids[source_term_id];
+        if (term_id == UNKNOWN_TERM) {
+            term_id = terms_.Intern(source.terms_.GetTerm(source_term_id));
+        }
+        term_freqs.emplace_back(term_id, term_freq);
+    }
+    sort(term_freqs.begin(), term_freqs.end());
+    if (term_to_document_freqs_.size() < terms_.size()) {
+        term_to_document_freqs_.resize(terms_.size());
+    }
+    // Как в AddDocument, остаётся документ с наименьшим id, но дубликат пропускается без исключения,
+    // чтобы слияние не обрывалось на середине
+    if (duplicate_policy_ == DuplicatePolicy::REJECT) {
+        const vector<int> duplicate_ids = FindDuplicateIds(term_freqs);
+        if (!duplicate_ids.empty() && duplicate_ids.front() < document_id) {
+            return;
+        }
+        for (const int duplicate_id : duplicate_ids) {
+            RemoveDocument(duplicate_id);
+        }
+    }
+    const int ordinal = AllocateOrdinal(document_id, source.ratings_[source_ordinal], source.statuses_[source_ordinal], move(term_freqs));
+    for (const auto& [term_id, term_freq] : document_term_freqs_[ordinal]) {
+        term_to_document_freqs_[term_id].Add(ordinal, term_freq);
+    }
+}
+
+void SearchServer::RemoveDocument(int document_id) {
+    MetricTimer timer(MetricStage::REMOVE_DOCUMENT);
+    const auto ordinal_it = document_to_ordinal_.find(document_id);
+    if (ordinal_it == document_to_ordinal_.end()) {
+        return;
+    }
+    const int ordinal = ordinal_it->second;
+    for (const auto& [term_id, term_freq] : document_term_freqs_[ordinal]) {
+        term_to_document_freqs_[term_id].Remove(ordinal);
+    }
+    ReleaseOrdinal(document_id, ordinal);
+}
+
+void SearchServer::RemoveDocument(const execution::sequenced_policy&, int document_id) {
+    RemoveDocument(document_id);
+}
+
+void SearchServer::RemoveDocument(const execution::parallel_policy&, int document_id) {
+    MetricTimer timer(MetricStage::REMOVE_DOCUMENT);
+    const auto ordinal_it = document_to_ordinal_.find(document_id);
+    if (ordinal_it == document_to_ordinal_.end()) {
+        return;
+    }
+    const int ordinal = ordinal_it->second;
+    const TermFreqs& term_freqs = document_term_freqs_[ordinal];
+    for_each(execution::par, term_freqs.begin(), term_freqs.end(),
+             [this, ordinal](const pair<TermId, float>& term_freq) {
+                 term_to_document_freqs_[term_freq.first].Remove(ordinal);
+             });
+    ReleaseOrdinal(document_id, ordinal);
+}
+
+void SearchServer::DetachDocument(int document_id, vector<bool>& touched_terms) {
+    const auto ordinal_it = document_to_ordinal_.find(document_id);
+    if (ordinal_it == document_to_ordinal_.end()) {
+        return;
+    }
+    const int ordinal = ordinal_it->second;
+    for (const auto& [term_id, term_freq] : document_term_freqs_[ordinal]) {
+        term_to_document_freqs_[term_id].MarkRemoved(ordinal);
+        touched_terms[term_id] = true;
+    }
+    ReleaseOrdinal(document_id, ordinal);
+}
+
+vector<Document> SearchServer::FindTopDocuments(string_view raw_query, DocumentStatus status, size_t max_result_count) const{
+    return FindTopDocuments(raw_query, StatusFilter(status), AcceptAnyDocument, max_result_count);
+}
+
+tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(string_view raw_query, int document_id) const{
+    QueryArena arena;
+    const Query query = ParseQuery(raw_query, arena.GetResource());
+    const int ordinal = document_to_ordinal_.at(document_id);
+    vector<string_view> MatchedWords;
+    for (const TermId term_id : query.minus_terms) {
+        if (term_to_document_freqs_[term_id].Contains(ordinal)) {
+            return make_tuple(vector<string_view>{},statuses_[ordinal]);
+        }
+    }
+    for (const TermId term_id : query.plus_terms) {
+        if (term_to_document_freqs_[term_id].Contains(ordinal)) {
+            MatchedWords.push_back(terms_.GetTerm(term_id));
         }
     }
     sort(MatchedWords.begin(),MatchedWords.end());
-    return make_tuple(MatchedWords,documents_.at(document_id).status);
+    return make_tuple(MatchedWords,statuses_[ordinal]);
+}
+
+tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(const execution::sequenced_policy&, string_view raw_query, int document_id) const {
+    return MatchDocument(raw_query, document_id);
+}
+
+tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(const execution::parallel_policy&, string_view raw_query, int document_id) const {
+    QueryArena arena;
+    const Query query = ParseQuery(raw_query, arena.GetResource());
+    const int ordinal = document_to_ordinal_.at(document_id);
+    const TermFreqs& term_freqs = document_term_freqs_[ordinal];
+    const auto contains_term = [&term_freqs](TermId term_id) {
+        return ContainsTerm(term_freqs, term_id);
+    };
+    if (any_of(execution::par, query.minus_terms.begin(), query.minus_terms.end(), contains_term)) {
+        return make_tuple(vector<string_view>{}, statuses_[ordinal]);
+    }
+    vector<TermId> matched_terms(query.plus_terms.size());
+    auto matched_end = copy_if(execution::par, query.plus_terms.begin(), query.plus_terms.end(),
+                               matched_terms.begin(), contains_term);
+    vector<string_view> matched_words(distance(matched_terms.begin(), matched_end));
+    transform(execution::par, matched_terms.begin(), matched_end, matched_words.begin(),
+              [this](TermId term_id) -> string_view { return terms_.GetTerm(term_id); });
+    sort(execution::par, matched_words.begin(), matched_words.end());
+    return make_tuple(matched_words, statuses_[ordinal]);
 }
 
 
-bool SearchServer::IsStopWord(const string& word) const {
+bool SearchServer::IsStopWord(string_view word) const {
     return stop_words_.count(word) > 0;
 }
 
-bool SearchServer::IsMinusWord(const string &word) {
-        if (word[0] == '-') {
+bool SearchServer::IsMinusWord(string_view word) {
+        if (!word.empty() && word[0] == '-') {
             if ( (word.size() == 1) || ((word.size()>1)&&(word[1]=='-')) ) {
                 throw invalid_argument("Invaid minus word"s);
             }
@@ -131,15 +548,15 @@ bool SearchServer::IsMinusWord(const string &word) {
         return false;
     }
 
-void SearchServer::SetStopWords(const string& text) {
-    for (const string& word : SplitIntoWords(text)) {
-        stop_words_.insert(word);
+void SearchServer::SetStopWords(string_view text) {
+    for (const string_view word : SplitIntoWords(text)) {
+        stop_words_.emplace(word);
     }
 }
 
-vector<string> SearchServer::SplitIntoWordsNoStop(const string& text) const {
-    vector<string> words;
-    for (const string& word : SplitIntoWords(text)) {
+vector<string_view> SearchServer::SplitIntoWordsNoStop(string_view text) const {
+    vector<string_view> words;
+    for (const string_view word : SplitIntoWords(text)) {
         if (!IsStopWord(word)) {
             words.push_back(word);
         }
@@ -151,7 +568,13 @@ int SearchServer::ComputeAverageRating(const vector<int>& ratings) {
     return (!ratings.size()?0:accumulate(ratings.begin(), ratings.end(),0, SecureSum)/static_cast<int>(ratings.size()));
 }
 
-SearchServer::QueryWord SearchServer::ParseQueryWord(string text) const {
+bool SearchServer::ContainsTerm(const TermFreqs& term_freqs, TermId term_id) {
+    const auto it = lower_bound(term_freqs.begin(), term_freqs.end(), term_id,
+                                [](const pair<TermId, float>& term_freq, TermId id) { return term_freq.first < id; });
+    return it != term_freqs.end() && it->first == term_id;
+}
+
+SearchServer::QueryWord SearchServer::ParseQueryWord(string_view text) const {
     bool is_minus = IsMinusWord(text);
     return {
         is_minus?text.substr(1):text,
@@ -160,63 +583,195 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(string text) const {
     };
 }
 
-SearchServer::Query SearchServer::ParseQuery(const string& text) const {
-    Query query;
-    for (const string& word : SplitIntoWords(text)) {
+SearchServer::Query SearchServer::ParseQuery(string_view text, pmr::memory_resource* resource) const {
+    MetricTimer timer(MetricStage::PARSE);
+    Query query(resource);
+    for (const string_view word : SplitIntoWords(text)) {
         const QueryWord query_word = ParseQueryWord(word);
         if (!query_word.is_stop) {
+            const auto term_id = terms_.Find(query_word.data);
+            if (!term_id) {
+                continue;
+            }
             if (query_word.is_minus) {
-                query.minus_words.insert(query_word.data);
+                query.minus_terms.insert(*term_id);
             }
             else {
-                query.plus_words.insert(query_word.data);
+                query.plus_terms.insert(*term_id);
             }
         }
     }
     return query;
 }
 
-double SearchServer::ComputeWordInverseDocumentFreq(const string& word) const {
-    return log(documents_.size() * 1.0 / word_to_document_freqs_.at(word).size());
+// Общая статистика нескольких серверов приходит с каждым запросом, поэтому по ней IDF не кэшируется.
+// Термин, которого нет в общей статистике (документ добавлен после её сбора), считается по своей
+// частоте, но по общему числу документов: иначе его релевантность была бы в масштабе одного сервера
+double SearchServer::ComputeWordInverseDocumentFreq(const Query& query, TermId term_id, size_t& idf_computed) const {
+    if (query.corpus_stats == nullptr) {
+        return idf_cache_.Get(term_id, term_to_document_freqs_[term_id].size(), idf_computed);
+    }
+    ++idf_computed;
+    size_t document_freq = term_to_document_freqs_[term_id].size();
+    const auto freq_it = query.corpus_stats->document_freqs.find(terms_.GetTerm(term_id));
+    if (freq_it != query.corpus_stats->document_freqs.end() && freq_it->second > 0) {
+        document_freq = freq_it->second;
+    }
+    return log(max(query.corpus_stats->document_count, document_freq) * 1.0 / document_freq);
 }
 
-vector<Document> SearchServer::FindAllDocuments(const Query& query) const {
-    map<int, double> document_to_relevance;
-    for (const string& word : query.plus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
+pmr::vector<pair<int, double>> SearchServer::FindAllDocuments(const execution::sequenced_policy&, const Query& query) const {
+    MetricTimer accumulate_timer(MetricStage::ACCUMULATE);
+    size_t postings_total = 0;
+    for (const TermId term_id : query.plus_terms) {
+        postings_total += term_to_document_freqs_[term_id].size();
+    }
+    RelevanceAccumulator accumulator(ordinal_to_document_.size(), postings_total, query.plus_terms.get_allocator().resource());
+    size_t postings_scored = 0;
+    size_t idf_computed = 0;
+    for (const TermId term_id : query.plus_terms) {
+        const auto& document_freqs = term_to_document_freqs_[term_id];
+        if (document_freqs.empty()) {
             continue;
         }
-        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-        for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-            document_to_relevance[document_id] += term_freq * inverse_document_freq;
+        const double inverse_document_freq = ComputeWordInverseDocumentFreq(query, term_id, idf_computed);
+        document_freqs.ForEach([&query, &accumulator, &postings_scored, inverse_document_freq](int ordinal, float term_freq) {
+            if (IsAllowed(query, ordinal)) {
+                accumulator.Add(ordinal, term_freq * inverse_document_freq);
+                ++postings_scored;
+            }
+        });
+    }
+
+    for (const TermId term_id : query.minus_terms) {
+        term_to_document_freqs_[term_id].ForEach([&accumulator](int ordinal, [[maybe_unused]] float term_freq) {
+            accumulator.Exclude(ordinal);
+        });
+    }
+    RecordQueryStats(postings_total, postings_scored, idf_computed);
+    accumulate_timer.Stop();
+    MetricTimer sort_timer(MetricStage::SORT);
+    auto document_to_relevance = accumulator.Extract();
+    Metrics::AddCounter(MetricCounter::DOCUMENTS_SCORED, document_to_relevance.size());
+    return document_to_relevance;
+}
+
+map<int, double> SearchServer::FindAllDocuments(const execution::parallel_policy&, const Query& query) const {
+    MetricTimer timer(MetricStage::ACCUMULATE);
+    ConcurrentMap<int, double> document_to_relevance(relevance_bucket_count_);
+    size_t postings_total = 0;
+    for (const TermId term_id : query.plus_terms) {
+        postings_total += term_to_document_freqs_[term_id].size();
+    }
+    // Счётчики терминов складываются в общие, чтобы статистика запроса совпадала с последовательным путём
+    atomic<size_t> query_postings_scored = 0;
+    atomic<size_t> query_idf_computed = 0;
+    for_each(execution::par, query.plus_terms.begin(), query.plus_terms.end(),
+             [this, &query, &document_to_relevance, &query_postings_scored, &query_idf_computed](TermId term_id) {
+                 const auto& document_freqs = term_to_document_freqs_[term_id];
+                 if (document_freqs.empty()) {
+                     return;
+                 }
+                 size_t idf_computed = 0;
+                 const double inverse_document_freq = ComputeWordInverseDocumentFreq(query, term_id, idf_computed);
+                 size_t postings_scored = 0;
+                 document_freqs.ForEach([&query, &document_to_relevance, &postings_scored, inverse_document_freq](int ordinal, float term_freq) {
+                     if (IsAllowed(query, ordinal)) {
+                         document_to_relevance[ordinal].ref_to_value += term_freq * inverse_document_freq;
+                         ++postings_scored;
+                     }
+                 });
+                 query_postings_scored += postings_scored;
+                 query_idf_computed += idf_computed;
+             });
+
+    for_each(execution::par, query.minus_terms.begin(), query.minus_terms.end(),
+             [this, &document_to_relevance](TermId term_id) {
+                 term_to_document_freqs_[term_id].ForEach([&document_to_relevance](int ordinal, [[maybe_unused]] float term_freq) {
+                     document_to_relevance.Erase(ordinal);
+                 });
+             });
+    RecordQueryStats(postings_total, query_postings_scored, query_idf_computed);
+    map<int, double> result = document_to_relevance.BuildOrdinaryMap();
+    Metrics::AddCounter(MetricCounter::DOCUMENTS_SCORED, result.size());
+    return result;
+}
+
+// При равенстве релевантности и рейтинга выше документ с меньшим id: порядок результатов
+// не зависит от того, в каком порядке документы добавлялись и какие внутренние номера получили
+bool SearchServer::IsMoreRelevant(const Document& lhs, const Document& rhs) {
+    if (std::abs(lhs.relevance - rhs.relevance) < EPSILON) {
+        if (lhs.rating == rhs.rating) {
+            return lhs.id < rhs.id;
         }
+        return lhs.rating > rhs.rating;
     }
+    return lhs.relevance > rhs.relevance;
+}
 
-    for (const string& word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
+// top_documents - куча, в вершине которой худший из отобранных документов
+void SearchServer::OfferTopDocument(vector<Document>& top_documents, const Document& document, size_t max_result_count) {
+    if (top_documents.size() == max_result_count) {
+        if (!IsMoreRelevant(document, top_documents.front())) {
+            return;
         }
-        for (const auto [document_id, freq] : word_to_document_freqs_.at(word)) {
-            document_to_relevance.erase(document_id);
+        pop_heap(top_documents.begin(), top_documents.end(), IsMoreRelevant);
+        top_documents.back() = document;
+    } else {
+        top_documents.push_back(document);
+    }
+    push_heap(top_documents.begin(), top_documents.end(), IsMoreRelevant);
+}
+
+void SearchServer::RecordQueryStats(size_t postings_total, size_t postings_scored, size_t idf_computed) {
+    Metrics::AddCounter(MetricCounter::POSTINGS_SCANNED, postings_scored);
+    last_query_stats.postings_total = postings_total;
+    last_query_stats.postings_scored = postings_scored;
+    last_query_stats.idf_computed = idf_computed;
+}
+
+bool SearchServer::IsExcluded(const Query& query, int ordinal) const {
+    return any_of(query.minus_terms.begin(), query.minus_terms.end(), [this, ordinal](TermId term_id) {
+        return term_to_document_freqs_[term_id].Contains(ordinal);
+    });
+}
+
+// Маска одного статуса берётся готовой, маска нескольких собирается в памяти запроса
+const uint64_t* SearchServer::BuildStatusMask(const StatusFilter& status_filter, pmr::memory_resource* resource) const {
+    if (status_filter.ContainsAll()) {
+        return nullptr;
+    }
+    MetricTimer timer(MetricStage::FILTER);
+    const size_t word_count = (ordinal_to_document_.size() + 63) / 64;
+    int status_count = 0;
+    int last_status = 0;
+    for (int status = 0; status < DOCUMENT_STATUS_COUNT; ++status) {
+        if (status_filter.Contains(static_cast<DocumentStatus>(status))) {
+            ++status_count;
+            last_status = status;
         }
     }
-    vector<Document> matched_documents;
-    for (const auto [document_id, relevance] : document_to_relevance) {
-            matched_documents.push_back({
-                document_id,
-                relevance,
-                documents_.at(document_id).rating
-            });
+    if (status_count == 1 && word_count > 0) {
+        return status_bitmaps_[last_status].data();
+    }
+    uint64_t* mask = static_cast<uint64_t*>(resource->allocate(max<size_t>(word_count, 1) * sizeof(uint64_t), alignof(uint64_t)));
+    fill(mask, mask + max<size_t>(word_count, 1), 0);
+    for (int status = 0; status < DOCUMENT_STATUS_COUNT; ++status) {
+        if (status_filter.Contains(static_cast<DocumentStatus>(status))) {
+            for (size_t i = 0; i < word_count; ++i) {
+                mask[i] |= status_bitmaps_[status][i];
+            }
+        }
     }
-    return matched_documents;
+    return mask;
 }
 
-void PrintMatchDocumentResult(int document_id, const vector<string>& words, DocumentStatus status) {
+void PrintMatchDocumentResult(int document_id, const vector<string_view>& words, DocumentStatus status) {
     cout << "{ "s
          << "document_id = "s << document_id << ", "s
          << "status = "s << static_cast<int>(status) << ", "s
          << "words ="s;
-    for (const string& word : words) {
+    for (const string_view word : words) {
         cout << ' ' << word;
     }
     cout << "}"s << endl;
@@ -255,34 +810,23 @@ void MatchDocuments(const SearchServer& search_server, const string& query)
     }
 }
 
-void RemoveDuplicates(SearchServer& search_server) {
-    set<set<string>> originals_content;
-    vector<int> duplicates_ids;
-    for (const int document_id : search_server) {
-        set<string> content;
-        for (const auto& [word, freq]: search_server.GetWordFrequencies(document_id)) {
-            content.emplace(word);
-        }
-        if (originals_content.count(content)!=0) {
-            duplicates_ids.push_back(document_id);
-            cout<<"Found duplicate document id "s<<document_id<<endl;
-        } else {
-            originals_content.emplace(content);
-        }
-    }
-    for (const int id : duplicates_ids) {
-        search_server.RemoveDocument(id);
+void RemoveDuplicates(SearchServer& search_server, double min_jaccard) {
+    const vector<int> duplicate_ids = DuplicateDetector(min_jaccard).FindDuplicates(search_server);
+    for (const int document_id : duplicate_ids) {
+        cout<<"Found duplicate document id "s<<document_id<<endl;
     }
+    search_server.RemoveDocuments(duplicate_ids);
 }
 
-
-
-
-
-
-
-
-
-
-
-
+vector<Document> MergeTopDocuments(const vector<vector<Document>>& partial_results, size_t max_result_count) {
+    vector<Document> documents;
+    documents.reserve(transform_reduce(partial_results.begin(), partial_results.end(), size_t{0}, plus<>{},
+                                       [](const vector<Document>& result) { return result.size(); }));
+    for (const vector<Document>& result : partial_results) {
+        documents.insert(documents.end(), result.begin(), result.end());
+    }
+    const size_t result_count = min(max_result_count, documents.size());
+    partial_sort(documents.begin(), documents.begin() + result_count, documents.end(), SearchServer::IsMoreRelevant);
+    documents.resize(result_count);
+    return documents;
+}
@@ -3,12 +3,31 @@
 #include "document.h"
 #include "string_processing.h"
 #include "log_duration.h"
+#include "concurrent_map.h"
+#include "term_dictionary.h"
+#include "posting_list.h"
+#include "query_arena.h"
+#include "relevance_accumulator.h"
+#include "idf_cache.h"
+#include "fingerprint.h"
+#include "metrics.h"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <execution>
+#include <initializer_list>
 #include <vector>
 #include <set>
+#include <limits>
 #include <map>
+#include <memory>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <stdexcept>
+#include <unordered_map>
 
 //#define SHOW_OPERATION_TIME
 
@@ -17,100 +36,411 @@ const double EPSILON = 1.0e-6;
 
 int SecureSum(int sum, int x);
 
+// Способ вычисления запроса: полный перебор вхождений или MaxScore с отсечением
+// документов, которые заведомо не попадут в результат. Результаты совпадают.
+enum class QueryEvaluation {
+    EXHAUSTIVE,
+    MAX_SCORE
+};
+
+// Поиск дубликатов при добавлении документа: дубликаты - документы с одинаковым множеством слов.
+// ALLOW - дубликаты не отслеживаются, REJECT - AddDocument не добавляет дубликат документа
+// с меньшим id, REPORT - дубликат добавляется, а исходный документ сообщает GetOriginalId
+enum class DuplicatePolicy {
+    ALLOW,
+    REJECT,
+    REPORT
+};
+
+// Набор допустимых статусов документа. Документы остальных статусов отбрасываются
+// по битовым маскам статусов ещё до подсчёта релевантности
+class StatusFilter {
+public:
+    // Допустимы все статусы
+    StatusFilter() = default;
+    explicit StatusFilter(DocumentStatus status);
+    StatusFilter(std::initializer_list<DocumentStatus> statuses);
+
+    bool Contains(DocumentStatus status) const;
+    bool ContainsAll() const;
+
+private:
+    unsigned mask_ = (1u << DOCUMENT_STATUS_COUNT) - 1;
+};
+
+// Предикат, пропускающий любой документ: для запросов, где отбор задан только статусами
+inline bool AcceptAnyDocument(int, DocumentStatus, int) {
+    return true;
+}
+
 class SearchServer {
+    friend void SaveIndex(const SearchServer& search_server, const std::string& path);
+    friend class DuplicateDetector;
 public:
+    // Статистика последнего запроса, выполненного в текущем потоке
+    struct QueryStats {
+        size_t postings_total = 0;
+        size_t postings_scored = 0;
+        // Значения IDF, которые пришлось вычислить, а не взять из кэша
+        size_t idf_computed = 0;
+    };
+    // Статистика коллекции для расчёта IDF. Когда документы распределены по нескольким серверам,
+    // запросы к ним выполняются с суммарной статистикой, и релевантность совпадает с единым индексом
+    struct CorpusStats {
+        size_t document_count = 0;
+        std::map<std::string, size_t, std::less<>> document_freqs;
+
+        CorpusStats& operator+=(const CorpusStats& other);
+        // Вычитаются только частоты слов, которые уже есть в статистике
+        CorpusStats& operator-=(const CorpusStats& other);
+    };
+
     template <typename StringContainer>
     explicit SearchServer(const StringContainer& stop_words)
         : stop_words_(MakeUniqueNonEmptyStrings(stop_words)) {
     }
     explicit SearchServer(const std::string& stop_words_text);
+    explicit SearchServer(std::string_view stop_words_text);
+    // Узлы индекса живут в пуле сервера: при перемещении пул переходит вместе с ними,
+    // а копирование и присваивание строят узлы заново в пуле сервера-получателя
+    SearchServer(const SearchServer& other);
+    SearchServer(SearchServer&&) = default;
+    SearchServer& operator=(const SearchServer& other);
+    SearchServer& operator=(SearchServer&& other);
 
     int GetDocumentCount() const;
-    const std::map<std::string, double>& GetWordFrequencies(int document_id) const;
+    bool HasDocument(int document_id) const;
+    // Версия индекса увеличивается при каждом изменении, от которого могут зависеть результаты поиска
+    uint64_t GetVersion() const;
+    // Ключ запроса для кэша результатов: не зависит от порядка и повторов слов, от стоп-слов
+    // и от слов, которых нет в индексе. Действителен, пока не изменилась версия индекса
+    std::string GetQueryKey(std::string_view raw_query) const;
+    const std::set<std::string, std::less<>>& GetStopWords() const;
+    void SetQueryEvaluation(QueryEvaluation query_evaluation);
+    // Допустимый дрейф числа документов, при котором кэш IDF не сбрасывается целиком (0 - IDF всегда точен).
+    // При частой записи ненулевой дрейф сохраняет кэш ценой ошибки IDF не больше |ln(1 - max_drift)|
+    void SetIdfMaxDrift(double max_drift);
+    // Кроме ALLOW, сервер поддерживает индекс отпечатков множеств слов, и проверка
+    // добавляемого документа стоит O(слов документа). Уже добавленные дубликаты остаются.
+    // При REJECT документ с меньшим id, чем у его дубликата в индексе, заменяет этот дубликат:
+    // как и после RemoveDuplicates, остаётся документ с наименьшим id
+    void SetDuplicatePolicy(DuplicatePolicy duplicate_policy);
+    // Наименьший id документа с тем же множеством слов, document_id при отсутствии дубликатов
+    int GetOriginalId(int document_id) const;
+    static QueryStats GetLastQueryStats();
+    CorpusStats GetCorpusStats(std::string_view raw_query) const;
+    std::map<std::string_view, double> GetWordFrequencies(int document_id) const;
     auto begin() const { return document_ids_.begin(); }
     auto end() const { return document_ids_.end(); }
-    void AddDocument(int document_id, const std::string& document, DocumentStatus status, const std::vector<int>& ratings);
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
     void RemoveDocument(int document_id);
-    std::vector<Document> FindTopDocuments(const std::string& raw_query, DocumentStatus status = DocumentStatus::ACTUAL) const;
+    // Переносит документы другого сервера без повторного разбора текста, кроме skipped_ids.
+    // Стоп-слова серверов должны совпадать. При DuplicatePolicy::REJECT дубликаты документов
+    // с меньшим id пропускаются, а дубликаты с большим id вытесняются
+    void MergeDocuments(const SearchServer& source, const std::set<int>& skipped_ids = {});
+    // Документы всех источников переносятся по возрастанию id, чтобы списки вхождений дописывались в конец
+    void MergeDocuments(const std::vector<const SearchServer*>& sources);
+    void RemoveDocument(const std::execution::sequenced_policy&, int document_id);
+    void RemoveDocument(const std::execution::parallel_policy&, int document_id);
+    template <typename DocumentIds>
+    void RemoveDocuments(const DocumentIds& document_ids) {
+        MetricTimer timer(MetricStage::REMOVE_DOCUMENT);
+        std::vector<bool> touched_terms(term_to_document_freqs_.size());
+        for (const int document_id : document_ids) {
+            DetachDocument(document_id, touched_terms);
+        }
+        for (TermId term_id = 0; term_id < touched_terms.size(); ++term_id) {
+            if (touched_terms[term_id]) {
+                term_to_document_freqs_[term_id].CompactIfSparse();
+            }
+        }
+    }
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status = DocumentStatus::ACTUAL,
+                                           size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
     template <typename KeyMapper>
-    std::vector<Document> FindTopDocuments(const std::string& raw_query, const KeyMapper& key_mapper) const {
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, const KeyMapper& key_mapper,
+                                           size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const {
+        return FindTopDocuments(std::execution::seq, raw_query, StatusFilter(), key_mapper, max_result_count);
+    }
+    // key_mapper вызывается только для документов, прошедших status_filter
+    template <typename KeyMapper>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, const StatusFilter& status_filter, const KeyMapper& key_mapper,
+                                           size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const {
+        return FindTopDocuments(std::execution::seq, raw_query, status_filter, key_mapper, max_result_count);
+    }
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status = DocumentStatus::ACTUAL,
+                                           size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const {
+        return FindTopDocuments(policy, raw_query, StatusFilter(status), AcceptAnyDocument, max_result_count);
+    }
+    template <typename ExecutionPolicy, typename KeyMapper>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, const KeyMapper& key_mapper,
+                                           size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const {
+        return FindTopDocuments(policy, raw_query, StatusFilter(), key_mapper, max_result_count);
+    }
+    template <typename ExecutionPolicy, typename KeyMapper>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, const StatusFilter& status_filter,
+                                           const KeyMapper& key_mapper, size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const {
 #ifdef SHOW_OPERATION_TIME
         LOG_DURATION_STREAM("Operation time", std::cout);
 #endif
-        const Query query = ParseQuery(raw_query);
-        std::vector<Document> found_documents = FindAllDocuments(query);
-        found_documents.erase(
-                remove_if( found_documents.begin(), found_documents.end(),
-                [this, key_mapper](const Document& document){
-                    return !key_mapper(document.id, documents_.at(document.id).status, document.rating);
-                }
-                ),
-                found_documents.end() );
-
-        sort(found_documents.begin(), found_documents.end(),
-             [](const Document& lhs, const Document& rhs) {
-                 if (std::abs(lhs.relevance - rhs.relevance) < EPSILON) {
-                   return lhs.rating > rhs.rating;
-                 }
-                 else {
-                    return lhs.relevance > rhs.relevance;
-                 }
-             });
-
-        if (found_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-            found_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
-                }
-        return found_documents;
+        QueryArena arena;
+        Query query = ParseQuery(raw_query, arena.GetResource());
+        query.allowed_ordinals = BuildStatusMask(status_filter, arena.GetResource());
+        if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>) {
+            if (query_evaluation_ == QueryEvaluation::MAX_SCORE) {
+                return FindTopDocumentsMaxScore(query, key_mapper, max_result_count);
+            }
+        }
+        return SelectTopDocuments(FindAllDocuments(policy, query), key_mapper, max_result_count);
+    }
+    template <typename KeyMapper>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, const CorpusStats& corpus_stats, const StatusFilter& status_filter,
+                                           const KeyMapper& key_mapper, size_t max_result_count) const {
+        QueryArena arena;
+        Query query = ParseQuery(raw_query, arena.GetResource());
+        query.corpus_stats = &corpus_stats;
+        query.allowed_ordinals = BuildStatusMask(status_filter, arena.GetResource());
+        if (query_evaluation_ == QueryEvaluation::MAX_SCORE) {
+            return FindTopDocumentsMaxScore(query, key_mapper, max_result_count);
+        }
+        return SelectTopDocuments(FindAllDocuments(std::execution::seq, query), key_mapper, max_result_count);
     }
-    std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(const std::string& raw_query, int document_id) const;
-    bool IsStopWord(const std::string& word) const;
-    static bool IsMinusWord(const std::string& word);
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::execution::sequenced_policy&, std::string_view raw_query, int document_id) const;
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::execution::parallel_policy&, std::string_view raw_query, int document_id) const;
+    bool IsStopWord(std::string_view word) const;
+    static bool IsMinusWord(std::string_view word);
+    static bool IsMoreRelevant(const Document& lhs, const Document& rhs);
+    // Добавляет документ в ограниченную кучу top_documents из не более max_result_count лучших
+    static void OfferTopDocument(std::vector<Document>& top_documents, const Document& document, size_t max_result_count);
 private:
     struct QueryWord {
-        std::string data;
+        std::string_view data;
         bool is_minus;
         bool is_stop;
     };
+    // В запросе остаются только слова, известные словарю: остальные не могут ни найти, ни исключить документ
+    // Временные структуры запроса размещаются в арене запроса
     struct Query {
-        std::set<std::string> plus_words;
-        std::set<std::string> minus_words;
-    };
-    struct DocumentData {
-        int rating;
-        DocumentStatus status;
-        std::map<std::string, double> word_to_freqs;
+        explicit Query(std::pmr::memory_resource* resource)
+            : plus_terms(resource)
+            , minus_terms(resource) {
+        }
+
+        std::pmr::set<TermId> plus_terms;
+        std::pmr::set<TermId> minus_terms;
+        const CorpusStats* corpus_stats = nullptr;
+        // Битовая маска внутренних номеров документов с допустимым статусом, nullptr - допустимы все
+        const uint64_t* allowed_ordinals = nullptr;
     };
+    using TermFreqs = std::pmr::vector<std::pair<TermId, float>>; // отсортирован по TermId
 private:
-    void SetStopWords(const std::string& text);
-    std::vector<std::string> SplitIntoWordsNoStop(const std::string& text) const;
+    template <typename Source>
+    void AssignIndex(Source&& other);
+    void SetStopWords(std::string_view text);
+    std::vector<std::string_view> SplitIntoWordsNoStop(std::string_view text) const;
     template <typename StringContainer>
-    std::set<std::string> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
-        std::set<std::string> non_empty_strings;
-        for (const std::string& str : strings) {
-            if (!str.empty() ) {
+    std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
+        std::set<std::string, std::less<>> non_empty_strings;
+        for (const auto& str : strings) {
+            if (!std::string_view(str).empty() ) {
                 if (CheckWord(str)) {
-                    non_empty_strings.insert(str);
+                    non_empty_strings.emplace(str);
                 }
             }
         }
         return non_empty_strings;
     }
     static int ComputeAverageRating(const std::vector<int>& ratings);
-    QueryWord ParseQueryWord(std::string text) const;
-    Query ParseQuery(const std::string& text) const ;
-    double ComputeWordInverseDocumentFreq(const std::string& word) const;
-    std::vector<Document> FindAllDocuments(const Query& query) const;
+    static bool ContainsTerm(const TermFreqs& term_freqs, TermId term_id);
+    static Fingerprint ComputeFingerprint(const TermFreqs& term_freqs);
+    static bool HaveSameTerms(const TermFreqs& lhs, const TermFreqs& rhs);
+    // id документов с тем же множеством терминов по возрастанию
+    std::vector<int> FindDuplicateIds(const TermFreqs& term_freqs) const;
+    void IndexFingerprint(int ordinal);
+    void UnindexFingerprint(int ordinal);
+    int AllocateOrdinal(int document_id, int rating, DocumentStatus status, TermFreqs term_freqs);
+    void ReleaseOrdinal(int document_id, int ordinal);
+    void RenumberOrdinals();
+    void DetachDocument(int document_id, std::vector<bool>& touched_terms);
+    void MergeDocument(const SearchServer& source, int document_id, int source_ordinal, std::vector<TermId>& term_ids);
+    QueryWord ParseQueryWord(std::string_view text) const;
+    Query ParseQuery(std::string_view text, std::pmr::memory_resource* resource) const;
+    double ComputeWordInverseDocumentFreq(const Query& query, TermId term_id, size_t& idf_computed) const;
+    // Найденные документы по возрастанию внутреннего номера
+    std::pmr::vector<std::pair<int, double>> FindAllDocuments(const std::execution::sequenced_policy&, const Query& query) const;
+    std::map<int, double> FindAllDocuments(const std::execution::parallel_policy&, const Query& query) const;
+    static void RecordQueryStats(size_t postings_total, size_t postings_scored, size_t idf_computed);
+    bool IsExcluded(const Query& query, int ordinal) const;
+    const uint64_t* BuildStatusMask(const StatusFilter& status_filter, std::pmr::memory_resource* resource) const;
+    static bool IsAllowed(const Query& query, int ordinal) {
+        return query.allowed_ordinals == nullptr || (query.allowed_ordinals[ordinal / 64] >> (ordinal % 64)) & 1;
+    }
+    // Отбор лучших документов ограниченной кучей: полная сортировка всех найденных не нужна
+    template <typename DocumentToRelevance, typename KeyMapper>
+    std::vector<Document> SelectTopDocuments(const DocumentToRelevance& document_to_relevance, const KeyMapper& key_mapper,
+                                             size_t max_result_count) const {
+        std::vector<Document> top_documents;
+        if (max_result_count == 0) {
+            return top_documents;
+        }
+        top_documents.reserve(max_result_count + 1);
+        MetricTimer top_k_timer(MetricStage::TOP_K);
+        for (const auto& [ordinal, relevance] : document_to_relevance) {
+            const int document_id = ordinal_to_document_[ordinal];
+            if (!key_mapper(document_id, statuses_[ordinal], ratings_[ordinal])) {
+                continue;
+            }
+            OfferTopDocument(top_documents, Document(document_id, relevance, ratings_[ordinal]), max_result_count);
+        }
+        top_k_timer.Stop();
+        MetricTimer sort_timer(MetricStage::SORT);
+        std::sort_heap(top_documents.begin(), top_documents.end(), IsMoreRelevant);
+        return top_documents;
+    }
+    // MaxScore: списки упорядочены по верхней границе вклада термина. Кандидаты берутся только из
+    // "существенных" списков, сумма границ остальных не дотягивает до порога top-K.
+    // Порог сравнивается с запасом EPSILON, поэтому отсекаются лишь документы, которые
+    // не прошли бы и при полном переборе, включая сравнение по рейтингу.
+    template <typename KeyMapper>
+    std::vector<Document> FindTopDocumentsMaxScore(const Query& query, const KeyMapper& key_mapper, size_t max_result_count) const {
+        MetricTimer accumulate_timer(MetricStage::ACCUMULATE);
+        struct ScoredTerm {
+            PostingList::Cursor cursor;
+            double inverse_document_freq;
+            double max_score;
+        };
+        std::pmr::memory_resource* resource = query.plus_terms.get_allocator().resource();
+        std::pmr::vector<ScoredTerm> terms(resource);
+        size_t postings_total = 0;
+        size_t idf_computed = 0;
+        for (const TermId term_id : query.plus_terms) {
+            const PostingList& postings = term_to_document_freqs_[term_id];
+            if (postings.empty()) {
+                continue;
+            }
+            const double inverse_document_freq = ComputeWordInverseDocumentFreq(query, term_id, idf_computed);
+            terms.push_back({PostingList::Cursor(postings), inverse_document_freq, postings.GetMaxTermFreq() * inverse_document_freq});
+            postings_total += postings.size();
+        }
+        std::sort(terms.begin(), terms.end(), [](const ScoredTerm& lhs, const ScoredTerm& rhs) {
+            return lhs.max_score < rhs.max_score;
+        });
+        std::pmr::vector<double> max_score_prefix(terms.size(), resource);
+        double max_score_sum = 0.0;
+        for (size_t i = 0; i < terms.size(); ++i) {
+            max_score_sum += terms[i].max_score;
+            max_score_prefix[i] = max_score_sum;
+        }
+
+        std::vector<Document> top_documents;
+        top_documents.reserve(max_result_count + 1);
+        size_t postings_scored = 0;
+        size_t documents_scored = 0;
+        size_t first_essential = 0;
+        while (max_result_count > 0) {
+            int candidate_ordinal = 0;
+            bool has_candidate = false;
+            for (size_t i = first_essential; i < terms.size(); ++i) {
+                if (!terms[i].cursor.AtEnd() && (!has_candidate || terms[i].cursor.GetDocumentId() < candidate_ordinal)) {
+                    candidate_ordinal = terms[i].cursor.GetDocumentId();
+                    has_candidate = true;
+                }
+            }
+            if (!has_candidate) {
+                break;
+            }
+            if (!IsAllowed(query, candidate_ordinal)) {
+                for (size_t i = first_essential; i < terms.size(); ++i) {
+                    PostingList::Cursor& cursor = terms[i].cursor;
+                    if (!cursor.AtEnd() && cursor.GetDocumentId() == candidate_ordinal) {
+                        cursor.Next();
+                    }
+                }
+                continue;
+            }
+            double relevance = 0.0;
+            for (size_t i = first_essential; i < terms.size(); ++i) {
+                PostingList::Cursor& cursor = terms[i].cursor;
+                if (!cursor.AtEnd() && cursor.GetDocumentId() == candidate_ordinal) {
+                    relevance += cursor.GetTermFreq() * terms[i].inverse_document_freq;
+                    cursor.Next();
+                    ++postings_scored;
+                }
+            }
+            const bool is_full = top_documents.size() == max_result_count;
+            bool is_pruned = false;
+            for (size_t i = first_essential; i-- > 0; ) {
+                if (is_full && relevance + max_score_prefix[i] < top_documents.front().relevance - EPSILON) {
+                    is_pruned = true;
+                    break;
+                }
+                PostingList::Cursor& cursor = terms[i].cursor;
+                cursor.SeekTo(candidate_ordinal);
+                if (!cursor.AtEnd() && cursor.GetDocumentId() == candidate_ordinal) {
+                    relevance += cursor.GetTermFreq() * terms[i].inverse_document_freq;
+                    ++postings_scored;
+                }
+            }
+            if (is_pruned || IsExcluded(query, candidate_ordinal)) {
+                continue;
+            }
+            ++documents_scored;
+            const int document_id = ordinal_to_document_[candidate_ordinal];
+            if (!key_mapper(document_id, statuses_[candidate_ordinal], ratings_[candidate_ordinal])) {
+                continue;
+            }
+            OfferTopDocument(top_documents, Document(document_id, relevance, ratings_[candidate_ordinal]), max_result_count);
+            if (top_documents.size() == max_result_count) {
+                const double threshold = top_documents.front().relevance - EPSILON;
+                while (first_essential < terms.size() && max_score_prefix[first_essential] < threshold) {
+                    ++first_essential;
+                }
+            }
+        }
+        RecordQueryStats(postings_total, postings_scored, idf_computed);
+        Metrics::AddCounter(MetricCounter::DOCUMENTS_SCORED, documents_scored);
+        accumulate_timer.Stop();
+        MetricTimer sort_timer(MetricStage::SORT);
+        std::sort_heap(top_documents.begin(), top_documents.end(), IsMoreRelevant);
+        return top_documents;
+    }
 private:
-    std::map<int, DocumentData> documents_;
-    std::vector<int> document_ids_; // Первый кандидат на удаление. Может отдавать итераторы documents_, а не на этот не совсем полезный вектор?
-    std::set<std::string> stop_words_;
-    std::map<std::string, std::map<int, double>> word_to_document_freqs_;
-    static const std::map<std::string, double> empty_word_freqs_;
+    std::unique_ptr<std::pmr::unsynchronized_pool_resource> index_resource_ = std::make_unique<std::pmr::unsynchronized_pool_resource>();
+    // Документам выдаются внутренние номера по порядку добавления. Номера удалённых документов
+    // не выдаются повторно, а убираются перенумерацией, когда их становится больше половины.
+    // Списки вхождений хранят номера, а свойства документов лежат в столбцах, индексированных номером
+    std::pmr::map<int, int> document_to_ordinal_{index_resource_.get()};
+    std::pmr::set<int> document_ids_{index_resource_.get()};
+    std::vector<int> ordinal_to_document_;
+    std::vector<int> ratings_;
+    std::vector<DocumentStatus> statuses_;
+    std::vector<TermFreqs> document_term_freqs_;
+    // Номера удалённых документов, ещё не убранные перенумерацией
+    size_t free_ordinal_count_ = 0;
+    // Для каждого статуса - битовая маска номеров документов с этим статусом
+    std::array<std::vector<uint64_t>, DOCUMENT_STATUS_COUNT> status_bitmaps_;
+    std::set<std::string, std::less<>> stop_words_;
+    TermDictionary terms_;
+    std::vector<PostingList> term_to_document_freqs_;
+    IdfCache idf_cache_;
+    QueryEvaluation query_evaluation_ = QueryEvaluation::EXHAUSTIVE;
+    DuplicatePolicy duplicate_policy_ = DuplicatePolicy::ALLOW;
+    // Номера документов по отпечатку множества терминов, пока duplicate_policy_ не ALLOW
+    std::unordered_map<Fingerprint, std::vector<int>, FingerprintHasher> fingerprint_to_ordinals_;
+    uint64_t version_ = 0;
+    static const size_t relevance_bucket_count_ = 100;
+    static constexpr TermId UNKNOWN_TERM = std::numeric_limits<TermId>::max();
+    static constexpr int FREE_ORDINAL = -1;
 };
 
-void PrintMatchDocumentResult(int document_id, const std::vector<std::string>& words, DocumentStatus status) ;
+void PrintMatchDocumentResult(int document_id, const std::vector<std::string_view>& words, DocumentStatus status) ;
 void AddDocument(SearchServer& search_server, int document_id, const std::string& document, DocumentStatus status,
                  const std::vector<int>& ratings) ;
 void FindTopDocuments(const SearchServer& search_server, const std::string& raw_query);
 void MatchDocuments(const SearchServer& search_server, const std::string& query);
-void RemoveDuplicates(SearchServer& search_server);
+// Удаляет дубликаты одним проходом RemoveDocuments, min_jaccard < 1 - вместе с близкими дубликатами
+void RemoveDuplicates(SearchServer& search_server, double min_jaccard = 1.0);
+// Слияние результатов, полученных от нескольких серверов с общей статистикой IDF
+std::vector<Document> MergeTopDocuments(const std::vector<std::vector<Document>>& partial_results, size_t max_result_count);
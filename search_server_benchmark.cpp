@@ -0,0 +1,244 @@
+#include "corpus_generator.h"
+#include "duplicate_detector.h"
+#include "paginator.h"
+#include "request_queue.h"
+#include "search_server.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Размеры коллекций. Переменная окружения SEARCH_BENCHMARK_MAX_DOCUMENTS ограничивает наибольший
+static const vector<int> CORPUS_SIZES = {10'000, 1'000'000, 10'000'000};
+static const vector<int> QUERY_TERM_COUNTS = {1, 2, 5, 10, 20};
+static const int QUERY_COUNT = 1'000;
+static const int DOCUMENT_POOL_SIZE = 1'000;
+// Документы удаляются пачками, после каждой пачки коллекция восстанавливается
+static const int REMOVE_BATCH_SIZE = 1'000;
+
+static CorpusOptions MakeCorpusOptions() {
+    CorpusOptions options;
+    options.duplicate_ratio = 0.01;
+    return options;
+}
+
+static const CorpusGenerator& GetCorpusGenerator() {
+    static const CorpusGenerator generator(MakeCorpusOptions());
+    return generator;
+}
+
+static void AddGeneratedDocument(SearchServer& search_server, int document_id) {
+    const GeneratedDocument document = GetCorpusGenerator().GenerateDocument(document_id);
+    search_server.AddDocument(document.id, document.text, document.status, document.ratings);
+}
+
+// Сервер одного размера строится один раз для всех тестов этого размера: тесты
+// регистрируются по возрастанию размера, и в памяти всегда только один сервер
+static SearchServer& GetSearchServer(int document_count) {
+    static unique_ptr<SearchServer> search_server;
+    static int server_document_count = 0;
+    if (!search_server || server_document_count != document_count) {
+        search_server.reset();
+        search_server = make_unique<SearchServer>(GetCorpusGenerator().GetStopWordsText());
+        for (int document_id = 0; document_id < document_count; ++document_id) {
+            AddGeneratedDocument(*search_server, document_id);
+        }
+        server_document_count = document_count;
+    }
+    return *search_server;
+}
+
+// Минус-слова - пятая часть слов запроса
+static vector<string> GenerateQueries(int term_count) {
+    vector<string> queries;
+    queries.reserve(QUERY_COUNT);
+    const int minus_word_count = term_count / 5;
+    for (int i = 0; i < QUERY_COUNT; ++i) {
+        queries.push_back(GetCorpusGenerator().GenerateQuery(i, term_count - minus_word_count, minus_word_count));
+    }
+    return queries;
+}
+
+static void BenchmarkAddDocument(benchmark::State& state) {
+    const int document_count = static_cast<int>(state.range(0));
+    SearchServer& search_server = GetSearchServer(document_count);
+    vector<GeneratedDocument> documents;
+    for (int i = 0; i < DOCUMENT_POOL_SIZE; ++i) {
+        documents.push_back(GetCorpusGenerator().GenerateDocument(document_count + i));
+    }
+    int document_id = document_count;
+    for (auto _ : state) {
+        const GeneratedDocument& document = documents[(document_id - document_count) % documents.size()];
+        search_server.AddDocument(document_id, document.text, document.status, document.ratings);
+        ++document_id;
+    }
+    vector<int> added_ids;
+    for (int id = document_count; id < document_id; ++id) {
+        added_ids.push_back(id);
+    }
+    search_server.RemoveDocuments(added_ids);
+}
+
+// Пара удаление + добавление: размер коллекции не меняется, удаляется самый старый документ
+static void BenchmarkAddDocumentChurn(benchmark::State& state) {
+    const int document_count = static_cast<int>(state.range(0));
+    SearchServer& search_server = GetSearchServer(document_count);
+    vector<GeneratedDocument> documents;
+    for (int i = 0; i < DOCUMENT_POOL_SIZE; ++i) {
+        documents.push_back(GetCorpusGenerator().GenerateDocument(document_count + i));
+    }
+    int removed_id = 0;
+    int document_id = document_count;
+    for (auto _ : state) {
+        search_server.RemoveDocument(removed_id++);
+        const GeneratedDocument& document = documents[(document_id - document_count) % documents.size()];
+        search_server.AddDocument(document_id, document.text, document.status, document.ratings);
+        ++document_id;
+    }
+    vector<int> added_ids;
+    for (int id = max(removed_id, document_count); id < document_id; ++id) {
+        added_ids.push_back(id);
+    }
+    search_server.RemoveDocuments(added_ids);
+    for (int id = 0; id < min(removed_id, document_count); ++id) {
+        AddGeneratedDocument(search_server, id);
+    }
+}
+
+static void BenchmarkRemoveDocument(benchmark::State& state) {
+    const int document_count = static_cast<int>(state.range(0));
+    SearchServer& search_server = GetSearchServer(document_count);
+    vector<int> removed_ids;
+    int next_id = 0;
+    for (auto _ : state) {
+        search_server.RemoveDocument(next_id);
+        removed_ids.push_back(next_id);
+        // Шаг взаимно прост с размерами коллекций, и удаляемые документы разбросаны по индексу
+        next_id = static_cast<int>((next_id + 7'919ll) % document_count);
+        if (removed_ids.size() == REMOVE_BATCH_SIZE || static_cast<int>(removed_ids.size()) == document_count) {
+            state.PauseTiming();
+            for (const int document_id : removed_ids) {
+                AddGeneratedDocument(search_server, document_id);
+            }
+            removed_ids.clear();
+            state.ResumeTiming();
+        }
+    }
+    for (const int document_id : removed_ids) {
+        AddGeneratedDocument(search_server, document_id);
+    }
+}
+
+static void BenchmarkFindTopDocuments(benchmark::State& state) {
+    const SearchServer& search_server = GetSearchServer(static_cast<int>(state.range(0)));
+    const vector<string> queries = GenerateQueries(static_cast<int>(state.range(1)));
+    size_t query_index = 0;
+    size_t postings_scored = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(search_server.FindTopDocuments(queries[query_index++ % queries.size()]));
+        postings_scored += SearchServer::GetLastQueryStats().postings_scored;
+    }
+    state.counters["postings_scored"] = benchmark::Counter(static_cast<double>(postings_scored), benchmark::Counter::kAvgIterations);
+}
+
+static void BenchmarkMatchDocument(benchmark::State& state) {
+    const int document_count = static_cast<int>(state.range(0));
+    const SearchServer& search_server = GetSearchServer(document_count);
+    const vector<string> queries = GenerateQueries(5);
+    size_t query_index = 0;
+    int document_id = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(search_server.MatchDocument(queries[query_index++ % queries.size()], document_id));
+        document_id = static_cast<int>((document_id + 7'919ll) % document_count);
+    }
+}
+
+// RemoveDuplicates - это поиск дубликатов и одно удаление RemoveDocuments. Измеряется поиск,
+// чтобы не перестраивать коллекцию на каждой итерации
+static void BenchmarkRemoveDuplicates(benchmark::State& state) {
+    const SearchServer& search_server = GetSearchServer(static_cast<int>(state.range(0)));
+    size_t duplicate_count = 0;
+    for (auto _ : state) {
+        duplicate_count = DuplicateDetector().FindDuplicates(search_server).size();
+    }
+    state.counters["duplicates"] = static_cast<double>(duplicate_count);
+}
+
+static void BenchmarkPaginate(benchmark::State& state) {
+    const SearchServer& search_server = GetSearchServer(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Paginator(search_server.begin(), search_server.end(), 10));
+    }
+    state.SetItemsProcessed(state.iterations() * search_server.GetDocumentCount());
+}
+
+static void BenchmarkRequestQueue(benchmark::State& state) {
+    const SearchServer& search_server = GetSearchServer(static_cast<int>(state.range(0)));
+    const vector<string> queries = GenerateQueries(3);
+    RequestQueue request_queue(search_server);
+    size_t query_index = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(request_queue.AddFindRequest(queries[query_index++ % queries.size()]));
+        benchmark::DoNotOptimize(request_queue.GetNoResultRequests());
+    }
+    state.counters["p99_us"] = request_queue.GetLatencyPercentile(0.99);
+}
+
+static void RegisterBenchmarks(int document_count) {
+    const auto unit = benchmark::kMicrosecond;
+    benchmark::RegisterBenchmark("AddDocument", BenchmarkAddDocument)->Arg(document_count)->Unit(unit);
+    benchmark::RegisterBenchmark("AddDocumentChurn", BenchmarkAddDocumentChurn)->Arg(document_count)->Unit(unit);
+    benchmark::RegisterBenchmark("RemoveDocument", BenchmarkRemoveDocument)->Arg(document_count)->Unit(unit);
+    for (const int term_count : QUERY_TERM_COUNTS) {
+        benchmark::RegisterBenchmark("FindTopDocuments", BenchmarkFindTopDocuments)->Args({document_count, term_count})->Unit(unit);
+    }
+    benchmark::RegisterBenchmark("MatchDocument", BenchmarkMatchDocument)->Arg(document_count)->Unit(unit);
+    benchmark::RegisterBenchmark("RemoveDuplicates", BenchmarkRemoveDuplicates)->Arg(document_count)->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark("Paginate", BenchmarkPaginate)->Arg(document_count)->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark("RequestQueue", BenchmarkRequestQueue)->Arg(document_count)->Unit(unit);
+}
+
+// Без --benchmark_out результаты пишутся в search_server_benchmark.json
+int main(int argc, char** argv) {
+    long long max_document_count = CORPUS_SIZES.back();
+    if (const char* limit = getenv("SEARCH_BENCHMARK_MAX_DOCUMENTS")) {
+        max_document_count = atoll(limit);
+    }
+    for (const int document_count : CORPUS_SIZES) {
+        if (document_count <= max_document_count) {
+            RegisterBenchmarks(document_count);
+        }
+    }
+
+    vector<string> arguments(argv, argv + argc);
+    if (none_of(arguments.begin(), arguments.end(), [](const string& argument) { return argument.rfind("--benchmark_out="s, 0) == 0; })) {
+        arguments.push_back("--benchmark_out=search_server_benchmark.json"s);
+        arguments.push_back("--benchmark_out_format=json"s);
+    }
+    vector<char*> argument_pointers;
+    for (string& argument : arguments) {
+        argument_pointers.push_back(argument.data());
+    }
+    int argument_count = static_cast<int>(argument_pointers.size());
+    benchmark::Initialize(&argument_count, argument_pointers.data());
+    if (benchmark::ReportUnrecognizedArguments(argument_count, argument_pointers.data())) {
+        return 1;
+    }
+    const CorpusOptions corpus_options = MakeCorpusOptions();
+    benchmark::AddCustomContext("corpus_seed", to_string(corpus_options.seed));
+    benchmark::AddCustomContext("corpus_vocabulary_size", to_string(corpus_options.vocabulary_size));
+    benchmark::AddCustomContext("corpus_zipf_exponent", to_string(corpus_options.zipf_exponent));
+    benchmark::AddCustomContext("corpus_document_length", to_string(corpus_options.min_document_length) + "-"s
+                                + to_string(corpus_options.max_document_length));
+    benchmark::AddCustomContext("corpus_stop_word_ratio", to_string(corpus_options.stop_word_ratio));
+    benchmark::AddCustomContext("corpus_duplicate_ratio", to_string(corpus_options.duplicate_ratio));
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,56 @@
+TEMPLATE = app
+CONFIG += console c++17
+CONFIG -= app_bundle
+CONFIG -= qt
+
+LIBS += -lbenchmark -ltbb -lpthread
+
+# Те же исходники, что у search_server_core в CMakeLists.txt
+SOURCES += search_server_benchmark.cpp \
+    boundary_scan.cpp \
+    bulk_loader.cpp \
+    corpus_generator.cpp \
+    document.cpp \
+    duplicate_detector.cpp \
+    idf_cache.cpp \
+    mapped_search_server.cpp \
+    metrics.cpp \
+    posting_list.cpp \
+    process_queries.cpp \
+    query_arena.cpp \
+    query_result_cache.cpp \
+    read_input_functions.cpp \
+    relevance_accumulator.cpp \
+    request_queue.cpp \
+    search_server.cpp \
+    sharded_search_server.cpp \
+    snapshot_search_server.cpp \
+    string_processing.cpp \
+    term_dictionary.cpp
+
+HEADERS += \
+    boundary_scan.h \
+    bounded_queue.h \
+    bulk_loader.h \
+    concurrent_map.h \
+    corpus_generator.h \
+    document.h \
+    duplicate_detector.h \
+    fingerprint.h \
+    idf_cache.h \
+    log_duration.h \
+    mapped_search_server.h \
+    metrics.h \
+    paginator.h \
+    posting_list.h \
+    process_queries.h \
+    query_arena.h \
+    query_result_cache.h \
+    read_input_functions.h \
+    relevance_accumulator.h \
+    request_queue.h \
+    search_server.h \
+    sharded_search_server.h \
+    snapshot_search_server.h \
+    string_processing.h \
+    term_dictionary.h
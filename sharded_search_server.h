@@ -0,0 +1,77 @@
+#pragma once
+
+#include "search_server.h"
+
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <vector>
+
+// Потокобезопасный сервер: документы распределены по независимым шардам по document_id,
+// у каждого шарда своя блокировка. Запись блокирует только свой шард, чтение идёт во все
+// шарды параллельно с общей статистикой IDF, и результаты шардов сливаются в общий top-K.
+// Запрос держит блокировку одного шарда за раз: статистика IDF собирается до подсчёта
+// релевантности, и документы, добавленные между этими шагами, могут не попасть в статистику.
+// Новые термины таких документов всё равно считаются по общему числу документов, в одном масштабе с остальными.
+class ShardedSearchServer {
+public:
+    template <typename StringContainer>
+    ShardedSearchServer(const StringContainer& stop_words, size_t shard_count) {
+        if (shard_count == 0) {
+            throw std::invalid_argument("shard_count == 0");
+        }
+        shards_.reserve(shard_count);
+        for (size_t i = 0; i < shard_count; ++i) {
+            shards_.push_back(std::make_unique<Shard>(stop_words));
+        }
+    }
+    ShardedSearchServer(const std::string& stop_words_text, size_t shard_count);
+
+    int GetDocumentCount() const;
+    size_t GetShardCount() const;
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    void RemoveDocument(int document_id);
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status = DocumentStatus::ACTUAL,
+                                           size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+    template <typename KeyMapper>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, const KeyMapper& key_mapper,
+                                           size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const {
+        return FindTopDocuments(raw_query, StatusFilter(), key_mapper, max_result_count);
+    }
+    template <typename KeyMapper>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, const StatusFilter& status_filter, const KeyMapper& key_mapper,
+                                           size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const {
+        // Шард блокируется только на время работы с ним, поэтому писатель ждёт лишь запросы,
+        // которые сейчас обходят его шард, а не все выполняющиеся запросы
+        SearchServer::CorpusStats corpus_stats;
+        for (const auto& shard : shards_) {
+            std::shared_lock lock(shard->mutex);
+            corpus_stats += shard->server.GetCorpusStats(raw_query);
+        }
+        std::vector<std::vector<Document>> shard_results(shards_.size());
+        std::transform(std::execution::par, shards_.begin(), shards_.end(), shard_results.begin(),
+                       [&](const std::unique_ptr<Shard>& shard) {
+                           std::shared_lock lock(shard->mutex);
+                           return shard->server.FindTopDocuments(raw_query, corpus_stats, status_filter, key_mapper, max_result_count);
+                       });
+        return MergeTopDocuments(shard_results, max_result_count);
+    }
+    // Найденные слова ссылаются на словарь шарда и остаются валидными, пока жив сервер
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
+
+private:
+    struct Shard {
+        template <typename StopWords>
+        explicit Shard(const StopWords& stop_words)
+            : server(stop_words) {
+        }
+
+        mutable std::shared_mutex mutex;
+        SearchServer server;
+    };
+
+    Shard& GetShard(int document_id) const;
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
@@ -0,0 +1,255 @@
+#include "snapshot_search_server.h"
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+
+using namespace std;
+
+SnapshotSearchServer::SnapshotSearchServer(const string& stop_words_text, size_t max_buffered_changes, size_t merge_factor)
+    : SnapshotSearchServer(SplitIntoWords(stop_words_text), max_buffered_changes, merge_factor) {
+}
+
+SnapshotSearchServer::~SnapshotSearchServer() {
+    {
+        lock_guard guard(writer_mutex_);
+        is_stopping_ = true;
+    }
+    merge_condition_.notify_all();
+    merge_thread_.join();
+}
+
+int SnapshotSearchServer::GetDocumentCount() const {
+    const shared_ptr<const Snapshot> snapshot = GetSnapshot();
+    int document_count = 0;
+    for (const Segment& segment : snapshot->segments) {
+        document_count += segment.index->GetDocumentCount();
+    }
+    return document_count - static_cast<int>(snapshot->removed_stats->document_count);
+}
+
+size_t SnapshotSearchServer::GetSegmentCount() const {
+    return GetSnapshot()->segments.size();
+}
+
+uint64_t SnapshotSearchServer::GetVersion() const {
+    return GetSnapshot()->version;
+}
+
+void SnapshotSearchServer::AddDocument(int document_id, string_view document, DocumentStatus status, const vector<int>& ratings) {
+    lock_guard guard(writer_mutex_);
+    if (document_ids_.count(document_id) > 0) {
+        throw invalid_argument("document already exists"s);
+    }
+    buffer_->AddDocument(document_id, document, status, ratings);
+    document_ids_.insert(document_id);
+    ++buffered_change_count_;
+    PublishIfFull();
+}
+
+void SnapshotSearchServer::RemoveDocument(int document_id) {
+    lock_guard guard(writer_mutex_);
+    if (document_ids_.erase(document_id) == 0) {
+        return;
+    }
+    if (buffer_->HasDocument(document_id)) {
+        buffer_->RemoveDocument(document_id);
+    } else {
+        pending_removed_ids_.push_back(document_id);
+    }
+    ++buffered_change_count_;
+    PublishIfFull();
+}
+
+void SnapshotSearchServer::Flush() {
+    lock_guard guard(writer_mutex_);
+    if (buffered_change_count_ > 0) {
+        Publish();
+    }
+}
+
+void SnapshotSearchServer::WaitForMerges() {
+    unique_lock lock(writer_mutex_);
+    merge_condition_.wait(lock, [this] {
+        return !is_merging_ && SelectSegmentsToMerge(*GetSnapshot()).empty();
+    });
+}
+
+vector<Document> SnapshotSearchServer::FindTopDocuments(string_view raw_query, DocumentStatus status, size_t max_result_count) const {
+    return FindTopDocuments(raw_query, StatusFilter(status), AcceptAnyDocument, max_result_count);
+}
+
+tuple<vector<string>, DocumentStatus> SnapshotSearchServer::MatchDocument(string_view raw_query, int document_id) const {
+    const shared_ptr<const Snapshot> snapshot = GetSnapshot();
+    for (const Segment& segment : snapshot->segments) {
+        if (segment.index->HasDocument(document_id) && segment.removed_ids->count(document_id) == 0) {
+            const auto [words, status] = segment.index->MatchDocument(raw_query, document_id);
+            return {vector<string>(words.begin(), words.end()), status};
+        }
+    }
+    throw out_of_range("document not found"s);
+}
+
+shared_ptr<const SnapshotSearchServer::Snapshot> SnapshotSearchServer::GetSnapshot() const {
+    return atomic_load(&snapshot_);
+}
+
+void SnapshotSearchServer::PublishIfFull() {
+    if (buffered_change_count_ >= max_buffered_changes_) {
+        Publish();
+    }
+}
+
+// Новый снимок собирается из старого копированием указателей; копируются только
+// наборы надгробий тех сегментов, из которых удалялись документы
+void SnapshotSearchServer::Publish() {
+    auto snapshot = make_shared<Snapshot>(*GetSnapshot());
+    if (!pending_removed_ids_.empty()) {
+        auto removed_stats = make_shared<SearchServer::CorpusStats>(*snapshot->removed_stats);
+        vector<shared_ptr<set<int>>> removed_ids(snapshot->segments.size());
+        for (const int document_id : pending_removed_ids_) {
+            for (size_t i = 0; i < snapshot->segments.size(); ++i) {
+                const Segment& segment = snapshot->segments[i];
+                if (!segment.index->HasDocument(document_id) || segment.removed_ids->count(document_id) > 0) {
+                    continue;
+                }
+                if (!removed_ids[i]) {
+                    removed_ids[i] = make_shared<set<int>>(*segment.removed_ids);
+                }
+                removed_ids[i]->insert(document_id);
+                ++removed_stats->document_count;
+                for (const auto& [word, term_freq] : segment.index->GetWordFrequencies(document_id)) {
+                    ++removed_stats->document_freqs[string(word)];
+                }
+                break;
+            }
+        }
+        for (size_t i = 0; i < snapshot->segments.size(); ++i) {
+            if (removed_ids[i]) {
+                snapshot->segments[i].removed_ids = move(removed_ids[i]);
+            }
+        }
+        snapshot->removed_stats = move(removed_stats);
+        pending_removed_ids_.clear();
+    }
+    if (buffer_->GetDocumentCount() > 0) {
+        snapshot->segments.push_back({shared_ptr<const SearchServer>(move(buffer_)), make_shared<const set<int>>()});
+        buffer_ = make_unique<SearchServer>(stop_words_);
+    }
+    ++snapshot->version;
+    atomic_store(&snapshot_, shared_ptr<const Snapshot>(move(snapshot)));
+    buffered_change_count_ = 0;
+    merge_condition_.notify_all();
+}
+
+void SnapshotSearchServer::StartMerging() {
+    if (merge_factor_ < 2) {
+        throw invalid_argument("merge_factor < 2"s);
+    }
+    merge_thread_ = thread([this] { RunMerges(); });
+}
+
+// Слияние строится без блокировки: писатели и читатели продолжают работать,
+// а результат публикуется вместе с надгробиями, появившимися за это время
+void SnapshotSearchServer::RunMerges() {
+    unique_lock lock(writer_mutex_);
+    while (true) {
+        merge_condition_.wait(lock, [this] {
+            return is_stopping_ || !SelectSegmentsToMerge(*GetSnapshot()).empty();
+        });
+        if (is_stopping_) {
+            return;
+        }
+        const shared_ptr<const Snapshot> snapshot = GetSnapshot();
+        vector<Segment> merged_segments;
+        for (const size_t i : SelectSegmentsToMerge(*snapshot)) {
+            merged_segments.push_back(snapshot->segments[i]);
+        }
+        is_merging_ = true;
+        lock.unlock();
+        SearchServer::CorpusStats dropped_stats;
+        unique_ptr<SearchServer> merged_index = BuildMergedIndex(merged_segments, dropped_stats);
+        lock.lock();
+        ReplaceSegments(merged_segments, move(merged_index), dropped_stats);
+        is_merging_ = false;
+        merge_condition_.notify_all();
+    }
+}
+
+// Многоуровневая политика: уровень сегмента определяется числом живых документов, каждый следующий
+// уровень в merge_factor_ раз больше предыдущего. Как только на уровне набирается merge_factor_
+// сегментов, они сливаются в сегмент следующего уровня, так что на каждом уровне их меньше merge_factor_.
+// Сегмент, в котором удалена больше половины документов, переписывается отдельно
+vector<size_t> SnapshotSearchServer::SelectSegmentsToMerge(const Snapshot& snapshot) const {
+    map<size_t, vector<size_t>> tiers;
+    for (size_t i = 0; i < snapshot.segments.size(); ++i) {
+        const Segment& segment = snapshot.segments[i];
+        const size_t document_count = segment.index->GetDocumentCount();
+        const size_t removed_count = segment.removed_ids->size();
+        if (removed_count * 2 > document_count) {
+            return {i};
+        }
+        size_t tier = 0;
+        for (size_t bound = max(max_buffered_changes_, size_t{1}); document_count - removed_count > bound; bound *= merge_factor_) {
+            ++tier;
+        }
+        vector<size_t>& tier_segments = tiers[tier];
+        tier_segments.push_back(i);
+        if (tier_segments.size() == merge_factor_) {
+            return tier_segments;
+        }
+    }
+    return {};
+}
+
+unique_ptr<SearchServer> SnapshotSearchServer::BuildMergedIndex(vector<Segment>& segments, SearchServer::CorpusStats& dropped_stats) const {
+    // Документы обычно поступают по возрастанию id: сегменты в таком порядке дописываются в конец списков вхождений
+    sort(segments.begin(), segments.end(), [](const Segment& lhs, const Segment& rhs) {
+        return *lhs.index->begin() < *rhs.index->begin();
+    });
+    auto merged_index = make_unique<SearchServer>(stop_words_);
+    for (const Segment& segment : segments) {
+        merged_index->MergeDocuments(*segment.index, *segment.removed_ids);
+        dropped_stats.document_count += segment.removed_ids->size();
+        for (const int document_id : *segment.removed_ids) {
+            for (const auto& [word, term_freq] : segment.index->GetWordFrequencies(document_id)) {
+                ++dropped_stats.document_freqs[string(word)];
+            }
+        }
+    }
+    return merged_index;
+}
+
+void SnapshotSearchServer::ReplaceSegments(const vector<Segment>& merged_segments, unique_ptr<SearchServer> merged_index,
+                                           const SearchServer::CorpusStats& dropped_stats) {
+    auto snapshot = make_shared<Snapshot>(*GetSnapshot());
+    auto removed_ids = make_shared<set<int>>();
+    vector<Segment> segments;
+    for (const Segment& segment : snapshot->segments) {
+        const auto merged_it = find_if(merged_segments.begin(), merged_segments.end(), [&segment](const Segment& merged_segment) {
+            return merged_segment.index == segment.index;
+        });
+        if (merged_it == merged_segments.end()) {
+            segments.push_back(segment);
+            continue;
+        }
+        set_difference(segment.removed_ids->begin(), segment.removed_ids->end(),
+                       merged_it->removed_ids->begin(), merged_it->removed_ids->end(),
+                       inserter(*removed_ids, removed_ids->end()));
+    }
+    if (merged_index->GetDocumentCount() > 0) {
+        segments.push_back({shared_ptr<const SearchServer>(move(merged_index)), move(removed_ids)});
+    }
+    auto removed_stats = make_shared<SearchServer::CorpusStats>(*snapshot->removed_stats);
+    removed_stats->document_count -= dropped_stats.document_count;
+    for (const auto& [word, document_freq] : dropped_stats.document_freqs) {
+        const auto freq_it = removed_stats->document_freqs.find(word);
+        if ((freq_it->second -= document_freq) == 0) {
+            removed_stats->document_freqs.erase(freq_it);
+        }
+    }
+    snapshot->segments = move(segments);
+    snapshot->removed_stats = move(removed_stats);
+    ++snapshot->version;
+    atomic_store(&snapshot_, shared_ptr<const Snapshot>(move(snapshot)));
+}
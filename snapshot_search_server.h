@@ -0,0 +1,115 @@
+#pragma once
+
+#include "search_server.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Сервер с изоляцией снимков: запросы читают неизменяемый снимок из сегментов и никогда не ждут запись.
+// Изменения копятся в буфере писателя и становятся видны атомарной публикацией нового снимка:
+// буфер замораживается в новый сегмент, удалённые из старых сегментов документы помечаются надгробиями.
+// Снимок, захваченный запросом, живёт, пока на него есть ссылки, даже если уже опубликован следующий.
+// Фоновый поток сливает сегменты по многоуровневой политике и физически удаляет помеченные документы,
+// поэтому число сегментов, которые читает запрос, растёт лишь логарифмически.
+class SnapshotSearchServer {
+public:
+    template <typename StringContainer>
+    explicit SnapshotSearchServer(const StringContainer& stop_words, size_t max_buffered_changes = 1000, size_t merge_factor = 4)
+        : stop_words_(std::begin(stop_words), std::end(stop_words))
+        , max_buffered_changes_(max_buffered_changes)
+        , merge_factor_(merge_factor)
+        , buffer_(std::make_unique<SearchServer>(stop_words_))
+        , snapshot_(std::make_shared<const Snapshot>()) {
+        StartMerging();
+    }
+    SnapshotSearchServer(const std::string& stop_words_text, size_t max_buffered_changes = 1000, size_t merge_factor = 4);
+    SnapshotSearchServer(const SnapshotSearchServer&) = delete;
+    SnapshotSearchServer& operator=(const SnapshotSearchServer&) = delete;
+    ~SnapshotSearchServer();
+
+    // Число документов в опубликованном снимке
+    int GetDocumentCount() const;
+    size_t GetSegmentCount() const;
+    uint64_t GetVersion() const;
+    // Изменения видны запросам после публикации: явной через Flush или автоматической,
+    // когда в буфере накопилось max_buffered_changes изменений
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    void RemoveDocument(int document_id);
+    void Flush();
+    // Ждёт, пока фоновое слияние приведёт сегменты в соответствие с политикой
+    void WaitForMerges();
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status = DocumentStatus::ACTUAL,
+                                           size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+    template <typename KeyMapper>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, const KeyMapper& key_mapper,
+                                           size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const {
+        return FindTopDocuments(raw_query, StatusFilter(), key_mapper, max_result_count);
+    }
+    template <typename KeyMapper>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, const StatusFilter& status_filter, const KeyMapper& key_mapper,
+                                           size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const {
+        const std::shared_ptr<const Snapshot> snapshot = GetSnapshot();
+        SearchServer::CorpusStats corpus_stats;
+        for (const Segment& segment : snapshot->segments) {
+            corpus_stats += segment.index->GetCorpusStats(raw_query);
+        }
+        corpus_stats -= *snapshot->removed_stats;
+        std::vector<std::vector<Document>> segment_results;
+        segment_results.reserve(snapshot->segments.size());
+        for (const Segment& segment : snapshot->segments) {
+            const std::set<int>& removed_ids = *segment.removed_ids;
+            segment_results.push_back(segment.index->FindTopDocuments(raw_query, corpus_stats, status_filter,
+                    [&removed_ids, &key_mapper](int document_id, DocumentStatus status, int rating) {
+                        return removed_ids.count(document_id) == 0 && key_mapper(document_id, status, rating);
+                    }, max_result_count));
+        }
+        return MergeTopDocuments(segment_results, max_result_count);
+    }
+    // Слова копируются: сегмент, на словарь которого они ссылались бы, может пережить только снимок
+    std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
+
+private:
+    struct Segment {
+        std::shared_ptr<const SearchServer> index;
+        std::shared_ptr<const std::set<int>> removed_ids;
+    };
+    struct Snapshot {
+        std::vector<Segment> segments;
+        // Статистика удалённых документов вычитается из суммарной, чтобы IDF совпадал с единым индексом
+        std::shared_ptr<const SearchServer::CorpusStats> removed_stats = std::make_shared<const SearchServer::CorpusStats>();
+        uint64_t version = 0;
+    };
+
+    std::shared_ptr<const Snapshot> GetSnapshot() const;
+    void PublishIfFull();
+    void Publish();
+    void StartMerging();
+    void RunMerges();
+    std::vector<size_t> SelectSegmentsToMerge(const Snapshot& snapshot) const;
+    std::unique_ptr<SearchServer> BuildMergedIndex(std::vector<Segment>& segments, SearchServer::CorpusStats& dropped_stats) const;
+    void ReplaceSegments(const std::vector<Segment>& merged_segments, std::unique_ptr<SearchServer> merged_index,
+                         const SearchServer::CorpusStats& dropped_stats);
+
+    const std::vector<std::string> stop_words_;
+    const size_t max_buffered_changes_;
+    const size_t merge_factor_;
+    // Состояние писателя и фонового слияния: доступно только под writer_mutex_
+    std::mutex writer_mutex_;
+    std::condition_variable merge_condition_;
+    bool is_merging_ = false;
+    bool is_stopping_ = false;
+    std::unique_ptr<SearchServer> buffer_;
+    std::set<int> document_ids_;
+    std::vector<int> pending_removed_ids_;
+    size_t buffered_change_count_ = 0;
+    // Читается и заменяется только через std::atomic_load / std::atomic_store
+    std::shared_ptr<const Snapshot> snapshot_;
+    std::thread merge_thread_;
+};
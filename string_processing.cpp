@@ -5,34 +5,42 @@
 
 using namespace std;
 
-bool IsValidWord(const string& word) {
+bool IsValidWord(string_view word) {
     return none_of(word.begin(), word.end(), [](char c) {
         return c >= '\0' && c < ' ';
     });
 }
 
-bool CheckWord(const string& word) {
+bool CheckWord(string_view word) {
     return (IsValidWord(word)?1: throw invalid_argument("Special symbol detected"s));
 }
 
-vector<string> SplitIntoWords(const string& text) {
-    vector<string> words;
-    string word;
-    for (const char c : text) {
-        if (c == ' ') {
-            if (CheckWord(word)) {
-                words.push_back(word);
+vector<string_view> SplitIntoWords(string_view text) {
+    return SplitIntoWords(text, GetBoundaryScanner());
+}
+
+// Текст обрабатывается кусками, битовая карта границ куска помещается на стеке
+vector<string_view> SplitIntoWords(string_view text, BoundaryScanner scanner) {
+    static const size_t chunk_size = 4096;
+    uint64_t bitmap[chunk_size / 64];
+    vector<string_view> words;
+    size_t word_start = 0;
+    for (size_t chunk_start = 0; chunk_start < text.size(); chunk_start += chunk_size) {
+        const size_t size = min(chunk_size, text.size() - chunk_start);
+        scanner(text.data() + chunk_start, size, bitmap);
+        for (size_t block = 0; block < (size + 63) / 64; ++block) {
+            for (uint64_t mask = bitmap[block]; mask != 0; mask &= mask - 1) {
+                const size_t position = chunk_start + block * 64 + __builtin_ctzll(mask);
+                if (text[position] != ' ') {
+                    throw invalid_argument("Special symbol detected"s);
+                }
+                words.push_back(text.substr(word_start, position - word_start));
+                word_start = position + 1;
             }
-            word = "";
-        }
-        else {
-            word += c;
         }
     }
-    if (!word.empty()) {
-        if(CheckWord(word)) {
-            words.push_back(word);
-        }
+    if (word_start < text.size()) {
+        words.push_back(text.substr(word_start));
     }
     return words;
 }
@@ -1,8 +1,13 @@
 #pragma once
 
+#include "boundary_scan.h"
+
 #include <vector>
 #include <string>
+#include <string_view>
 
-bool IsValidWord(const std::string& word);
-bool CheckWord(const std::string& word);
-std::vector<std::string> SplitIntoWords(const std::string& text);
+bool IsValidWord(std::string_view word);
+bool CheckWord(std::string_view word);
+// Слова ссылаются на символы text, поэтому text должен пережить результат
+std::vector<std::string_view> SplitIntoWords(std::string_view text);
+std::vector<std::string_view> SplitIntoWords(std::string_view text, BoundaryScanner scanner);
@@ -0,0 +1,46 @@
+#include "term_dictionary.h"
+
+using namespace std;
+
+TermDictionary::TermDictionary(const TermDictionary& other)
+    : terms_(other.terms_) {
+    term_ids_.reserve(terms_.size());
+    for (TermId term_id = 0; term_id < terms_.size(); ++term_id) {
+        term_ids_.emplace(terms_[term_id], term_id);
+    }
+}
+
+TermDictionary& TermDictionary::operator=(const TermDictionary& other) {
+    if (this != &other) {
+        TermDictionary copy(other);
+        *this = move(copy);
+    }
+    return *this;
+}
+
+TermId TermDictionary::Intern(string_view term) {
+    const auto it = term_ids_.find(term);
+    if (it != term_ids_.end()) {
+        return it->second;
+    }
+    const TermId term_id = static_cast<TermId>(terms_.size());
+    terms_.emplace_back(term);
+    term_ids_.emplace(terms_.back(), term_id);
+    return term_id;
+}
+
+optional<TermId> TermDictionary::Find(string_view term) const {
+    const auto it = term_ids_.find(term);
+    if (it == term_ids_.end()) {
+        return nullopt;
+    }
+    return it->second;
+}
+
+const string& TermDictionary::GetTerm(TermId term_id) const {
+    return terms_.at(term_id);
+}
+
+size_t TermDictionary::size() const {
+    return terms_.size();
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+using TermId = uint32_t;
+
+// Словарь терминов: каждое слово хранится в единственном экземпляре
+// и получает плотный числовой идентификатор. Идентификаторы не переиспользуются.
+class TermDictionary {
+public:
+    TermDictionary() = default;
+    // Ключи индекса ссылаются на строки своего словаря, поэтому при копировании индекс строится заново
+    TermDictionary(const TermDictionary& other);
+    TermDictionary& operator=(const TermDictionary& other);
+    TermDictionary(TermDictionary&&) = default;
+    TermDictionary& operator=(TermDictionary&&) = default;
+
+    TermId Intern(std::string_view term);
+    std::optional<TermId> Find(std::string_view term) const;
+    const std::string& GetTerm(TermId term_id) const;
+    size_t size() const;
+
+private:
+    // deque не перемещает элементы при добавлении, поэтому string_view в ключах остаются валидными
+    std::deque<std::string> terms_;
+    std::unordered_map<std::string_view, TermId> term_ids_;
+};
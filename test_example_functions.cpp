@@ -1,10 +1,31 @@
 #include "test_example_functions.h"
+#include "bulk_loader.h"
+#include "corpus_generator.h"
+#include "duplicate_detector.h"
+#include "mapped_search_server.h"
+#include "metrics.h"
 #include "paginator.h"
+#include "process_queries.h"
 #include "request_queue.h"
+#include "posting_list.h"
+#include "query_arena.h"
+#include "query_result_cache.h"
+#include "relevance_accumulator.h"
+#include "sharded_search_server.h"
+#include "snapshot_search_server.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <execution>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <thread>
 
 using namespace std;
 
@@ -476,3 +497,1216 @@ void TestQueue() {
 
 
 
+
+void TestParallelExecution() {
+    mt19937 generator(42);
+    const vector<string> dictionary = {"cat"s, "dog"s, "bird"s, "city"s, "village"s, "big"s, "small"s, "orange"s,
+                                       "black"s, "white"s, "tail"s, "collar"s, "fluffy"s, "fancy"s, "starling"s};
+    const auto random_text = [&generator, &dictionary](int word_count) {
+        string text;
+        for (int i = 0; i < word_count; ++i) {
+            text += dictionary[uniform_int_distribution<size_t>(0, dictionary.size() - 1)(generator)] + " "s;
+        }
+        return text;
+    };
+
+    SearchServer seq_server("and with"s);
+    SearchServer par_server("and with"s);
+    for (int id = 0; id < 200; ++id) {
+        const string text = random_text(uniform_int_distribution(1, 10)(generator));
+        const DocumentStatus status = static_cast<DocumentStatus>(id % 4);
+        const vector<int> ratings = {id % 7 - 3, id % 5};
+        seq_server.AddDocument(id, text, status, ratings);
+        par_server.AddDocument(id, text, status, ratings);
+    }
+    for (int id = 0; id < 200; id += 3) {
+        seq_server.RemoveDocument(execution::seq, id);
+        par_server.RemoveDocument(execution::par, id);
+    }
+    ASSERT_EQUAL_HINT(seq_server.GetDocumentCount(), par_server.GetDocumentCount(), "Parallel RemoveDocument error"s);
+
+    const auto same_documents = [](const vector<Document>& lhs, const vector<Document>& rhs) {
+        return equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const Document& l, const Document& r) {
+            return l.id == r.id && l.rating == r.rating && std::abs(l.relevance - r.relevance) < 1.0e-6;
+        });
+    };
+    for (int i = 0; i < 50; ++i) {
+        const string query = random_text(uniform_int_distribution(1, 5)(generator)) + "-"s + random_text(1);
+        ASSERT_HINT(same_documents(seq_server.FindTopDocuments(execution::seq, query),
+                                   par_server.FindTopDocuments(execution::par, query)), "Parallel FindTopDocuments error"s);
+        ASSERT_HINT(same_documents(seq_server.FindTopDocuments(query, DocumentStatus::BANNED),
+                                   par_server.FindTopDocuments(execution::par, query, DocumentStatus::BANNED)), "Parallel status filter error"s);
+        const auto even_rating = []([[maybe_unused]] int document_id, [[maybe_unused]] DocumentStatus status, int rating) { return rating % 2 == 0; };
+        ASSERT_HINT(same_documents(seq_server.FindTopDocuments(query, even_rating),
+                                   par_server.FindTopDocuments(execution::par, query, even_rating)), "Parallel predicate error"s);
+        for (const int document_id : seq_server) {
+            ASSERT_HINT(seq_server.MatchDocument(execution::seq, query, document_id) == par_server.MatchDocument(execution::par, query, document_id),
+                        "Parallel MatchDocument error"s);
+        }
+    }
+}
+
+void TestProcessQueries() {
+    SearchServer search_server("and with"s);
+    search_server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    search_server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2, 3});
+    search_server.AddDocument(3, "big cat nasty hair"s, DocumentStatus::ACTUAL, {1, 2, 8});
+    search_server.AddDocument(4, "big dog cat Vladislav"s, DocumentStatus::ACTUAL, {1, 3, 2});
+    search_server.AddDocument(5, "big dog hamster Borya"s, DocumentStatus::ACTUAL, {1, 1, 1});
+
+    const vector<string> queries = {"nasty rat -not"s, "not very funny nasty pet"s, "curly hair"s, "unknown"s, "big"s};
+    const auto results = ProcessQueries(search_server, queries);
+    ASSERT_EQUAL_HINT(results.size(), queries.size(), "ProcessQueries result count error"s);
+    vector<int> expected_ids;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const auto expected = search_server.FindTopDocuments(queries[i]);
+        ASSERT_EQUAL_HINT(results[i].size(), expected.size(), "ProcessQueries result size error"s);
+        for (size_t j = 0; j < expected.size(); ++j) {
+            ASSERT_EQUAL_HINT(results[i][j].id, expected[j].id, "ProcessQueries result error"s);
+            expected_ids.push_back(expected[j].id);
+        }
+    }
+    ASSERT_HINT(results[3].empty(), "ProcessQueries returned documents for unknown word"s);
+
+    const auto joined = ProcessQueriesJoined(search_server, queries);
+    ASSERT_EQUAL_HINT(joined.size(), expected_ids.size(), "ProcessQueriesJoined size error"s);
+    vector<int> joined_ids;
+    for (const Document& document : joined) {
+        joined_ids.push_back(document.id);
+    }
+    ASSERT_EQUAL_HINT(joined_ids, expected_ids, "ProcessQueriesJoined order error"s);
+    const auto empty_joined = ProcessQueriesJoined(search_server, {"unknown"s, "-big"s});
+    ASSERT_HINT(empty_joined.begin() == empty_joined.end(), "ProcessQueriesJoined empty result error"s);
+}
+
+void TestTermDictionary() {
+    TermDictionary dictionary;
+    const TermId cat = dictionary.Intern("cat"s);
+    const TermId dog = dictionary.Intern("dog"s);
+    ASSERT_HINT(cat != dog, "Different terms share id"s);
+    ASSERT_EQUAL_HINT(dictionary.Intern("cat"s), cat, "Term interned twice"s);
+    ASSERT_EQUAL_HINT(dictionary.size(), 2u, "Dictionary size error"s);
+    ASSERT_EQUAL_HINT(dictionary.GetTerm(dog), "dog"s, "Term lookup error"s);
+    ASSERT_HINT(dictionary.Find("dog"s) == dog, "Term search error"s);
+    ASSERT_HINT(!dictionary.Find("bird"s), "Unknown term found"s);
+
+    SearchServer server(""s);
+    server.AddDocument(1, "cat and cat and dog"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(2, "dog"s, DocumentStatus::ACTUAL, {1});
+    const auto word_freqs = server.GetWordFrequencies(1);
+    ASSERT_EQUAL_HINT(word_freqs.size(), 3u, "Word frequencies size error"s);
+    ASSERT_HINT(std::abs(word_freqs.at("cat"s) - 0.4) < 1.0e-6, "Word frequency error"s);
+    ASSERT_HINT(server.GetWordFrequencies(3).empty(), "Word frequencies of absent document"s);
+    server.RemoveDocument(1);
+    ASSERT_HINT(server.FindTopDocuments("cat"s).empty(), "Removed document found"s);
+    ASSERT_EQUAL_HINT(server.FindTopDocuments("cat dog"s).size(), 1u, "Search after removal error"s);
+}
+
+void TestPostingList() {
+    PostingList postings;
+    postings.Add(5, 0.5f);
+    postings.Add(1, 0.25f);
+    postings.Add(9, 1.0f);
+    postings.Add(3, 0.75f);
+    const auto collect_ids = [&postings]() {
+        vector<int> ids;
+        postings.ForEach([&ids](int document_id, [[maybe_unused]] float term_freq) { ids.push_back(document_id); });
+        return ids;
+    };
+    ASSERT_EQUAL_HINT(collect_ids(), (vector<int>{1, 3, 5, 9}), "Postings are not sorted"s);
+    ASSERT_HINT(postings.Remove(3), "Posting removal error"s);
+    ASSERT_HINT(!postings.Remove(3), "Posting removed twice"s);
+    ASSERT_HINT(!postings.Remove(4), "Absent posting removed"s);
+    ASSERT_HINT(!postings.Contains(3), "Removed posting found"s);
+    ASSERT_EQUAL_HINT(postings.size(), 3u, "Posting count error"s);
+    ASSERT_EQUAL_HINT(collect_ids(), (vector<int>{1, 5, 9}), "Removed posting visited"s);
+    postings.Add(3, 0.5f);
+    ASSERT_HINT(postings.Contains(3), "Re-added posting missed"s);
+    postings.Remove(1);
+    postings.Remove(5);
+    postings.Remove(9);
+    ASSERT_EQUAL_HINT(collect_ids(), (vector<int>{3}), "Compaction error"s);
+    postings.Remove(3);
+    ASSERT_HINT(postings.empty(), "Empty postings error"s);
+}
+
+void TestRemoveDocuments() {
+    SearchServer server("and with"s);
+    server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2, 3});
+    server.AddDocument(3, "big cat nasty hair"s, DocumentStatus::ACTUAL, {1, 2, 8});
+    server.AddDocument(4, "big dog cat Vladislav"s, DocumentStatus::ACTUAL, {1, 3, 2});
+    server.AddDocument(5, "big dog hamster Borya"s, DocumentStatus::ACTUAL, {1, 1, 1});
+
+    server.RemoveDocument(42);
+    ASSERT_EQUAL_HINT(server.GetDocumentCount(), 5, "Absent document removal error"s);
+    server.RemoveDocuments(vector<int>{2, 4, 42, 4});
+    ASSERT_EQUAL_HINT(server.GetDocumentCount(), 3, "Bulk removal error"s);
+    ASSERT_EQUAL_HINT(vector<int>(server.begin(), server.end()), (vector<int>{1, 3, 5}), "Document ids error after bulk removal"s);
+    ASSERT_HINT(server.FindTopDocuments("curly Vladislav"s).empty(), "Removed documents found"s);
+    ASSERT_EQUAL_HINT(server.FindTopDocuments("big dog"s).size(), 2u, "Search after bulk removal error"s);
+    server.RemoveDocuments(set<int>{1, 3, 5});
+    ASSERT_EQUAL_HINT(server.GetDocumentCount(), 0, "Bulk removal of all documents error"s);
+    ASSERT_HINT(server.FindTopDocuments("big dog funny"s).empty(), "Search in empty server error"s);
+    server.AddDocument(4, "big dog"s, DocumentStatus::ACTUAL, {1});
+    ASSERT_EQUAL_HINT(server.FindTopDocuments("dog"s).size(), 1u, "Re-added document missed"s);
+}
+
+void TestMaxResultCount() {
+    SearchServer server(""s);
+    for (int id = 0; id < 20; ++id) {
+        string text = "cat"s;
+        for (int i = 0; i < id % 4; ++i) {
+            text += " dog"s;
+        }
+        server.AddDocument(id, text, id % 3 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL, {id});
+    }
+    const auto all_documents = server.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, 100);
+    ASSERT_EQUAL_HINT(all_documents.size(), 13u, "Unbounded result count error"s);
+    for (size_t i = 0; i + 1 < all_documents.size(); ++i) {
+        const Document& lhs = all_documents[i];
+        const Document& rhs = all_documents[i + 1];
+        ASSERT_HINT(lhs.relevance > rhs.relevance + 1.0e-6 || (std::abs(lhs.relevance - rhs.relevance) < 1.0e-6 && lhs.rating >= rhs.rating),
+                    "Top documents order error"s);
+    }
+    for (size_t count : {0u, 1u, 3u, 5u, 13u}) {
+        const auto top_documents = server.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, count);
+        ASSERT_EQUAL_HINT(top_documents.size(), count, "Top documents count error"s);
+        for (size_t i = 0; i < count; ++i) {
+            ASSERT_EQUAL_HINT(top_documents[i].id, all_documents[i].id, "Top documents selection error"s);
+        }
+    }
+    ASSERT_EQUAL_HINT(server.FindTopDocuments("cat"s).size(), static_cast<size_t>(MAX_RESULT_DOCUMENT_COUNT), "Default result count error"s);
+    const auto banned_top = server.FindTopDocuments(execution::par, "cat"s, DocumentStatus::BANNED, 2);
+    ASSERT_EQUAL_HINT(banned_top.size(), 2u, "Parallel top documents count error"s);
+    const auto odd_top = server.FindTopDocuments("cat"s, [](int document_id, [[maybe_unused]] DocumentStatus status, [[maybe_unused]] int rating) {
+        return document_id % 2 == 1;
+    }, 7);
+    ASSERT_EQUAL_HINT(odd_top.size(), 7u, "Predicate top documents count error"s);
+    ASSERT_HINT(all_of(odd_top.begin(), odd_top.end(), [](const Document& document) { return document.id % 2 == 1; }),
+                "Predicate top documents error"s);
+}
+
+void TestMaxScoreEvaluation() {
+    mt19937 generator(7);
+    vector<string> dictionary;
+    vector<double> weights;
+    for (int i = 0; i < 60; ++i) {
+        dictionary.push_back("w"s + to_string(i));
+        weights.push_back(1.0 / (i + 1));
+    }
+    discrete_distribution<size_t> word_distribution(weights.begin(), weights.end());
+    const auto random_text = [&](int word_count) {
+        string text;
+        for (int i = 0; i < word_count; ++i) {
+            text += dictionary[word_distribution(generator)] + " "s;
+        }
+        return text;
+    };
+
+    SearchServer server(""s);
+    for (int id = 0; id < 300; ++id) {
+        server.AddDocument(id * 2, random_text(uniform_int_distribution(1, 12)(generator)),
+                           static_cast<DocumentStatus>(id % 3), {id % 11 - 5});
+    }
+    server.RemoveDocuments(vector<int>{10, 20, 30, 40, 50});
+
+    const auto same_documents = [](const vector<Document>& lhs, const vector<Document>& rhs) {
+        return equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const Document& l, const Document& r) {
+            return l.id == r.id && l.rating == r.rating && std::abs(l.relevance - r.relevance) < 1.0e-9;
+        });
+    };
+    const auto rating_filter = []([[maybe_unused]] int document_id, [[maybe_unused]] DocumentStatus status, int rating) {
+        return rating > -3;
+    };
+    size_t postings_total = 0;
+    size_t postings_scored = 0;
+    for (int i = 0; i < 100; ++i) {
+        string query = random_text(uniform_int_distribution(2, 10)(generator));
+        if (i % 3 == 0) {
+            query += "-"s + random_text(1);
+        }
+        const size_t count = uniform_int_distribution<size_t>(1, 10)(generator);
+        server.SetQueryEvaluation(QueryEvaluation::EXHAUSTIVE);
+        const auto expected = server.FindTopDocuments(query, DocumentStatus::ACTUAL, count);
+        const auto expected_filtered = server.FindTopDocuments(query, rating_filter, count);
+        server.SetQueryEvaluation(QueryEvaluation::MAX_SCORE);
+        ASSERT_HINT(same_documents(server.FindTopDocuments(query, DocumentStatus::ACTUAL, count), expected), "MaxScore result differs"s);
+        ASSERT_HINT(same_documents(server.FindTopDocuments(query, rating_filter, count), expected_filtered), "MaxScore predicate result differs"s);
+        const SearchServer::QueryStats stats = SearchServer::GetLastQueryStats();
+        ASSERT_HINT(stats.postings_scored <= stats.postings_total, "MaxScore statistics error"s);
+        postings_total += stats.postings_total;
+        postings_scored += stats.postings_scored;
+    }
+    ASSERT_HINT(postings_scored < postings_total, "MaxScore skipped nothing"s);
+
+    // Параллельный запрос тоже сохраняет свою статистику
+    SearchServer par_server("and"s);
+    par_server.AddDocument(1, "fluffy cat"s, DocumentStatus::ACTUAL, {1});
+    par_server.AddDocument(2, "fluffy dog"s, DocumentStatus::ACTUAL, {1});
+    par_server.AddDocument(3, "big dog"s, DocumentStatus::BANNED, {1});
+    par_server.FindTopDocuments("cat"s);
+    par_server.FindTopDocuments(execution::par, "fluffy dog"s);
+    const SearchServer::QueryStats par_stats = SearchServer::GetLastQueryStats();
+    ASSERT_EQUAL_HINT(par_stats.postings_total, 4u, "Parallel query postings total error"s);
+    ASSERT_EQUAL_HINT(par_stats.postings_scored, 3u, "Parallel query postings scored error"s);
+    ASSERT_EQUAL_HINT(par_stats.idf_computed, 2u, "Parallel query IDF statistics error"s);
+}
+
+void TestSplitIntoWords() {
+    const string text = "funny  pet and rat "s;
+    const vector<string_view> words = SplitIntoWords(text);
+    ASSERT_EQUAL_HINT(words, (vector<string_view>{"funny"sv, ""sv, "pet"sv, "and"sv, "rat"sv}), "Split error"s);
+    ASSERT_HINT(words[0].data() == text.data(), "Words are copied"s);
+    ASSERT_HINT(SplitIntoWords(""sv).empty(), "Empty text split error"s);
+    ASSERT_EQUAL_HINT(SplitIntoWords(" "sv), (vector<string_view>{""sv}), "Single space split error"s);
+    try {
+        SplitIntoWords("funny p\x01et"sv);
+        ASSERT_HINT(false, "Special symbol split fail"s);
+    } catch (const invalid_argument&) {}
+
+    SearchServer server(string_view("and with"));
+    ASSERT_HINT(server.IsStopWord("and"sv), "Stop word missed"s);
+    server.AddDocument(1, "funny pet and nasty rat"sv, DocumentStatus::ACTUAL, {1});
+    vector<string_view> matched_words;
+    {
+        const string query = "rat funny -dog"s;
+        matched_words = get<0>(server.MatchDocument(query, 1));
+    }
+    ASSERT_EQUAL_HINT(matched_words, (vector<string_view>{"funny"sv, "rat"sv}), "Matched words must outlive the query"s);
+}
+
+void TestBoundaryScanners() {
+    vector<BoundaryScanner> scanners = {ScanBoundariesScalar, GetBoundaryScanner()};
+#if defined(__x86_64__) || defined(__i386__)
+    scanners.push_back(ScanBoundariesSse2);
+    if (__builtin_cpu_supports("avx2")) {
+        scanners.push_back(ScanBoundariesAvx2);
+    }
+#endif
+    mt19937 generator(13);
+    const string alphabet = "ab  \xd0\xba\xff-"s;
+    for (int i = 0; i < 300; ++i) {
+        string text;
+        const int length = uniform_int_distribution(0, i < 290 ? 200 : 9000)(generator);
+        for (int j = 0; j < length; ++j) {
+            text.push_back(alphabet[uniform_int_distribution<size_t>(0, alphabet.size() - 1)(generator)]);
+        }
+        if (i % 5 == 0 && !text.empty()) {
+            text[uniform_int_distribution<size_t>(0, text.size() - 1)(generator)] = static_cast<char>(i % 32);
+        }
+        vector<string_view> expected;
+        bool expected_throw = false;
+        try {
+            expected = SplitIntoWords(text, ScanBoundariesScalar);
+        } catch (const invalid_argument&) {
+            expected_throw = true;
+        }
+        ASSERT_EQUAL_HINT(expected_throw, !IsValidWord(text), "Scalar control character check error"s);
+        for (const BoundaryScanner scanner : scanners) {
+            try {
+                ASSERT_EQUAL_HINT(SplitIntoWords(text, scanner), expected, "Boundary scanner split error"s);
+                ASSERT_HINT(!expected_throw, "Boundary scanner missed control character"s);
+            } catch (const invalid_argument& e) {
+                ASSERT_HINT(expected_throw, "Boundary scanner false control character"s);
+                ASSERT_EQUAL_HINT(string(e.what()), "Special symbol detected"s, "Exception message changed"s);
+            }
+        }
+    }
+}
+
+void TestShardedSearchServer() {
+    mt19937 generator(21);
+    const vector<string> dictionary = {"cat"s, "dog"s, "bird"s, "city"s, "village"s, "big"s, "small"s, "orange"s,
+                                       "black"s, "white"s, "tail"s, "collar"s, "fluffy"s, "fancy"s, "starling"s, "and"s};
+    const auto random_text = [&generator, &dictionary](int word_count) {
+        string text;
+        for (int i = 0; i < word_count; ++i) {
+            text += dictionary[uniform_int_distribution<size_t>(0, dictionary.size() - 1)(generator)] + " "s;
+        }
+        return text;
+    };
+
+    SearchServer server("and"s);
+    ShardedSearchServer sharded_server("and"s, 4);
+    for (int id = 0; id < 300; ++id) {
+        const string text = random_text(uniform_int_distribution(1, 8)(generator));
+        const DocumentStatus status = id % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+        server.AddDocument(id, text, status, {id});
+        sharded_server.AddDocument(id, text, status, {id});
+    }
+    for (int id = 0; id < 300; id += 7) {
+        server.RemoveDocument(id);
+        sharded_server.RemoveDocument(id);
+    }
+    ASSERT_EQUAL_HINT(sharded_server.GetDocumentCount(), server.GetDocumentCount(), "Sharded document count error"s);
+    try {
+        sharded_server.AddDocument(1, "cat"s, DocumentStatus::ACTUAL, {});
+        ASSERT_HINT(false, "Sharded duplicate document fail"s);
+    } catch (const invalid_argument&) {}
+
+    for (int i = 0; i < 50; ++i) {
+        const string query = random_text(uniform_int_distribution(1, 4)(generator)) + "-"s + random_text(1);
+        const auto expected = server.FindTopDocuments(query, DocumentStatus::ACTUAL, 10);
+        const auto found = sharded_server.FindTopDocuments(query, DocumentStatus::ACTUAL, 10);
+        ASSERT_EQUAL_HINT(found.size(), expected.size(), "Sharded result size error"s);
+        for (size_t j = 0; j < found.size(); ++j) {
+            ASSERT_EQUAL_HINT(found[j].id, expected[j].id, "Sharded result error"s);
+            ASSERT_HINT(std::abs(found[j].relevance - expected[j].relevance) < 1.0e-9, "Sharded relevance differs"s);
+        }
+        ASSERT_HINT(sharded_server.MatchDocument(query, 1) == server.MatchDocument(query, 1), "Sharded MatchDocument error"s);
+    }
+
+    vector<thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&sharded_server, t]() {
+            for (int i = 0; i < 100; ++i) {
+                const int id = 1000 + t * 100 + i;
+                sharded_server.AddDocument(id, "fluffy cat number "s + to_string(i), DocumentStatus::ACTUAL, {i});
+                sharded_server.FindTopDocuments("fluffy cat"s);
+                if (i % 2 == 0) {
+                    sharded_server.RemoveDocument(id);
+                }
+            }
+        });
+    }
+    for (thread& worker : threads) {
+        worker.join();
+    }
+    ASSERT_EQUAL_HINT(sharded_server.GetDocumentCount(), server.GetDocumentCount() + 200, "Concurrent sharded updates error"s);
+
+    // Термин, которого нет в общей статистике, считается по общему числу документов, а не по своему шарду
+    SearchServer shard("and"s);
+    shard.AddDocument(1, "cat"s, DocumentStatus::ACTUAL, {1});
+    shard.AddDocument(2, "new word"s, DocumentStatus::ACTUAL, {1});
+    SearchServer::CorpusStats corpus_stats = shard.GetCorpusStats("cat"s);
+    corpus_stats.document_count = 100;
+    const auto missing_term = shard.FindTopDocuments("new"s, corpus_stats, StatusFilter(DocumentStatus::ACTUAL),
+                                                    []([[maybe_unused]] int document_id, [[maybe_unused]] DocumentStatus status, [[maybe_unused]] int rating) {
+                                                        return true;
+                                                    }, 5);
+    ASSERT_EQUAL_HINT(missing_term.size(), 1u, "Term missing from corpus stats not found"s);
+    ASSERT_HINT(std::abs(missing_term.front().relevance - 0.5 * log(100.0)) < EPSILON, "Term missing from corpus stats scored locally"s);
+
+    // Документы с новыми словами добавляются во время запросов: IDF нового слова из единственного
+    // документа лежит между значениями единого индекса до и после запроса, а после записи результаты
+    // совпадают с единым индексом
+    ShardedSearchServer growing_server(""s, 4);
+    SearchServer single_server(""s);
+    for (int id = 0; id < 8; ++id) {
+        growing_server.AddDocument(id, "word"s + to_string(id), DocumentStatus::ACTUAL, {1});
+        single_server.AddDocument(id, "word"s + to_string(id), DocumentStatus::ACTUAL, {1});
+    }
+    const int final_count = 400;
+    atomic<bool> inconsistent = false;
+    thread reader([&growing_server, &inconsistent, final_count] {
+        for (int count = growing_server.GetDocumentCount(); count < final_count; count = growing_server.GetDocumentCount()) {
+            for (int id = max(count - 2, 0); id < min(count + 2, final_count); ++id) {
+                const auto found = growing_server.FindTopDocuments("word"s + to_string(id));
+                const int count_after = growing_server.GetDocumentCount();
+                if (!found.empty() && (found.front().relevance < log(count) - EPSILON || found.front().relevance > log(count_after) + EPSILON)) {
+                    inconsistent = true;
+                }
+            }
+        }
+    });
+    for (int id = 8; id < final_count; ++id) {
+        growing_server.AddDocument(id, "word"s + to_string(id), DocumentStatus::ACTUAL, {1});
+        single_server.AddDocument(id, "word"s + to_string(id), DocumentStatus::ACTUAL, {1});
+    }
+    reader.join();
+    ASSERT_HINT(!inconsistent, "Sharded relevance mixed global and shard IDF"s);
+    for (int id = 0; id < final_count; id += 37) {
+        const string query = "word"s + to_string(id) + " word"s + to_string(id + 1);
+        const auto expected = single_server.FindTopDocuments(query);
+        const auto found = growing_server.FindTopDocuments(query);
+        ASSERT_EQUAL_HINT(found.size(), expected.size(), "Sharded result size error after concurrent writes"s);
+        for (size_t j = 0; j < found.size(); ++j) {
+            ASSERT_EQUAL_HINT(found[j].id, expected[j].id, "Sharded result error after concurrent writes"s);
+            ASSERT_HINT(std::abs(found[j].relevance - expected[j].relevance) < 1.0e-9, "Sharded relevance differs after concurrent writes"s);
+        }
+    }
+}
+
+void TestSnapshotSearchServer() {
+    mt19937 generator(42);
+    const vector<string> dictionary = {"cat"s, "dog"s, "bird"s, "city"s, "village"s, "big"s, "small"s, "orange"s,
+                                       "black"s, "white"s, "tail"s, "collar"s, "fluffy"s, "fancy"s, "starling"s, "and"s};
+    const auto random_text = [&generator, &dictionary](int word_count) {
+        string text;
+        for (int i = 0; i < word_count; ++i) {
+            text += dictionary[uniform_int_distribution<size_t>(0, dictionary.size() - 1)(generator)] + " "s;
+        }
+        return text;
+    };
+
+    SearchServer server("and"s);
+    SnapshotSearchServer snapshot_server("and"s, 64);
+    snapshot_server.AddDocument(0, "fluffy cat"s, DocumentStatus::ACTUAL, {1});
+    ASSERT_HINT(snapshot_server.FindTopDocuments("cat"s).empty(), "Unpublished document is visible"s);
+    snapshot_server.Flush();
+    ASSERT_EQUAL_HINT(snapshot_server.FindTopDocuments("cat"s).size(), 1u, "Published document is not visible"s);
+    server.AddDocument(0, "fluffy cat"s, DocumentStatus::ACTUAL, {1});
+    try {
+        snapshot_server.AddDocument(0, "cat"s, DocumentStatus::ACTUAL, {});
+        ASSERT_HINT(false, "Snapshot duplicate document fail"s);
+    } catch (const invalid_argument&) {}
+
+    for (int id = 1; id < 300; ++id) {
+        const string text = random_text(uniform_int_distribution(1, 8)(generator));
+        const DocumentStatus status = id % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+        server.AddDocument(id, text, status, {id});
+        snapshot_server.AddDocument(id, text, status, {id});
+    }
+    for (int id = 0; id < 300; id += 7) {
+        server.RemoveDocument(id);
+        snapshot_server.RemoveDocument(id);
+    }
+    // Документ, удалённый из опубликованного сегмента, можно добавить заново
+    server.AddDocument(14, "fancy starling"s, DocumentStatus::ACTUAL, {5});
+    snapshot_server.AddDocument(14, "fancy starling"s, DocumentStatus::ACTUAL, {5});
+    snapshot_server.Flush();
+    snapshot_server.WaitForMerges();
+    // Буфер на 64 изменения и 4 сегмента на слияние: не больше трёх сегментов на уровнях до 64, 256 и 1024 документов
+    ASSERT_HINT(snapshot_server.GetSegmentCount() <= 9, "Snapshot segments are not merged"s);
+    ASSERT_EQUAL_HINT(snapshot_server.GetDocumentCount(), server.GetDocumentCount(), "Snapshot document count error"s);
+
+    for (int i = 0; i < 50; ++i) {
+        const string query = random_text(uniform_int_distribution(1, 4)(generator)) + "-"s + random_text(1);
+        const auto expected = server.FindTopDocuments(query, DocumentStatus::ACTUAL, 10);
+        const auto found = snapshot_server.FindTopDocuments(query, DocumentStatus::ACTUAL, 10);
+        ASSERT_EQUAL_HINT(found.size(), expected.size(), "Snapshot result size error"s);
+        for (size_t j = 0; j < found.size(); ++j) {
+            ASSERT_EQUAL_HINT(found[j].id, expected[j].id, "Snapshot result error"s);
+            ASSERT_HINT(std::abs(found[j].relevance - expected[j].relevance) < 1.0e-9, "Snapshot relevance differs"s);
+        }
+        const auto [expected_words, expected_status] = server.MatchDocument(query, 14);
+        const auto [found_words, found_status] = snapshot_server.MatchDocument(query, 14);
+        ASSERT_HINT(vector<string>(expected_words.begin(), expected_words.end()) == found_words && expected_status == found_status,
+                    "Snapshot MatchDocument error"s);
+    }
+
+    // Читатели работают одновременно с писателем и видят только опубликованные снимки
+    atomic_bool is_writing = true;
+    vector<thread> readers;
+    for (int t = 0; t < 3; ++t) {
+        readers.emplace_back([&snapshot_server, &is_writing]() {
+            while (is_writing) {
+                const auto documents = snapshot_server.FindTopDocuments("fluffy cat"s);
+                ASSERT_HINT(documents.size() <= MAX_RESULT_DOCUMENT_COUNT, "Concurrent snapshot read error"s);
+            }
+        });
+    }
+    for (int i = 0; i < 400; ++i) {
+        snapshot_server.AddDocument(1000 + i, "fluffy cat number "s + to_string(i), DocumentStatus::ACTUAL, {i});
+        if (i % 2 == 0) {
+            snapshot_server.RemoveDocument(1000 + i);
+        }
+    }
+    snapshot_server.Flush();
+    snapshot_server.WaitForMerges();
+    is_writing = false;
+    for (thread& reader : readers) {
+        reader.join();
+    }
+    ASSERT_EQUAL_HINT(snapshot_server.GetDocumentCount(), server.GetDocumentCount() + 200, "Concurrent snapshot updates error"s);
+}
+
+void TestMappedSearchServer() {
+    mt19937 generator(7);
+    const vector<string> dictionary = {"cat"s, "dog"s, "bird"s, "city"s, "village"s, "big"s, "small"s, "orange"s,
+                                       "black"s, "white"s, "tail"s, "collar"s, "fluffy"s, "fancy"s, "starling"s, "and"s};
+    const auto random_text = [&generator, &dictionary](int word_count) {
+        string text;
+        for (int i = 0; i < word_count; ++i) {
+            text += dictionary[uniform_int_distribution<size_t>(0, dictionary.size() - 1)(generator)] + " "s;
+        }
+        return text;
+    };
+
+    SearchServer server("and -cat"s);
+    for (int id = 0; id < 300; ++id) {
+        const DocumentStatus status = id % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+        server.AddDocument(id * 3, random_text(uniform_int_distribution(1, 8)(generator)), status, {id});
+    }
+    server.AddDocument(1000, "starling"s, DocumentStatus::ACTUAL, {1});
+    for (int id = 0; id < 900; id += 21) {
+        server.RemoveDocument(id);
+    }
+    server.RemoveDocument(1000);
+
+    const string path = (filesystem::temp_directory_path() / "search_server_test.idx"s).string();
+    SaveIndex(server, path);
+    {
+        const MappedSearchServer mapped_server(path);
+        ASSERT_EQUAL_HINT(mapped_server.GetDocumentCount(), server.GetDocumentCount(), "Mapped document count error"s);
+        for (int i = 0; i < 50; ++i) {
+            const string query = random_text(uniform_int_distribution(1, 4)(generator)) + "-"s + random_text(1) + " -cat"s;
+            // Маленький top-K и фильтр по рейтингу проверяют отсечение MaxScore по границам из файла
+            const size_t count = i % 10 + 1;
+            const auto expected = server.FindTopDocuments(query, DocumentStatus::ACTUAL, count);
+            const auto found = mapped_server.FindTopDocuments(query, DocumentStatus::ACTUAL, count);
+            const auto odd_rating = []([[maybe_unused]] int document_id, [[maybe_unused]] DocumentStatus status, int rating) {
+                return rating % 2 != 0;
+            };
+            const auto expected_filtered = server.FindTopDocuments(query, odd_rating, count);
+            const auto found_filtered = mapped_server.FindTopDocuments(query, odd_rating, count);
+            ASSERT_EQUAL_HINT(found.size(), expected.size(), "Mapped result size error"s);
+            ASSERT_EQUAL_HINT(found_filtered.size(), expected_filtered.size(), "Mapped filtered result size error"s);
+            for (size_t j = 0; j < found.size(); ++j) {
+                ASSERT_EQUAL_HINT(found[j].id, expected[j].id, "Mapped result error"s);
+                ASSERT_HINT(std::abs(found[j].relevance - expected[j].relevance) < 1.0e-9, "Mapped relevance differs"s);
+            }
+            for (size_t j = 0; j < found_filtered.size(); ++j) {
+                ASSERT_EQUAL_HINT(found_filtered[j].id, expected_filtered[j].id, "Mapped filtered result error"s);
+            }
+            ASSERT_HINT(mapped_server.MatchDocument(query, 3) == server.MatchDocument(query, 3), "Mapped MatchDocument error"s);
+        }
+        ASSERT_HINT(mapped_server.FindTopDocuments("starling"s, [](int document_id, DocumentStatus, int) {
+            return document_id == 1000;
+        }).empty(), "Removed document saved"s);
+        try {
+            mapped_server.MatchDocument("cat"s, 0);
+            ASSERT_HINT(false, "Mapped missing document fail"s);
+        } catch (const out_of_range&) {}
+    }
+    // Испорченные файлы: мусор, завышенные количества, усечённый файл с исправленным размером
+    string index_data;
+    {
+        ifstream index_file(path, ios::binary);
+        index_data.assign(istreambuf_iterator<char>(index_file), istreambuf_iterator<char>());
+    }
+    const auto patched = [&index_data](size_t field_offset, uint64_t value) {
+        string data = index_data;
+        memcpy(data.data() + field_offset, &value, sizeof(value));
+        return data;
+    };
+    string truncated = index_data.substr(0, index_data.size() / 2);
+    const uint64_t truncated_size = truncated.size();
+    memcpy(truncated.data() + offsetof(IndexFileHeader, file_size), &truncated_size, sizeof(truncated_size));
+    for (const string& broken_data : {string(256, 'x'), patched(offsetof(IndexFileHeader, document_count), 1'000'000),
+                                      patched(offsetof(IndexFileHeader, term_count), 1'000'000),
+                                      patched(offsetof(IndexFileHeader, posting_count), 1'000'000), truncated}) {
+        {
+            ofstream broken(path, ios::binary | ios::trunc);
+            broken << broken_data;
+        }
+        try {
+            MappedSearchServer broken_server(path);
+            ASSERT_HINT(false, "Invalid index file accepted"s);
+        } catch (const invalid_argument&) {}
+    }
+    // Граница частоты первого термина ("big") меньше его частот: ошибка видна при обходе списка
+    {
+        IndexFileHeader header;
+        memcpy(&header, index_data.data(), sizeof(header));
+        string broken_data = index_data;
+        const float max_term_freq = 0.0f;
+        memcpy(broken_data.data() + header.posting_ranges_offset + offsetof(IndexFilePostingRange, max_term_freq), &max_term_freq,
+               sizeof(max_term_freq));
+        {
+            ofstream broken(path, ios::binary | ios::trunc);
+            broken << broken_data;
+        }
+        const MappedSearchServer broken_server(path);
+        try {
+            broken_server.FindTopDocuments("big"s);
+            ASSERT_HINT(false, "Posting above max_term_freq accepted"s);
+        } catch (const invalid_argument&) {}
+    }
+    filesystem::remove(path);
+}
+
+void TestBulkLoader() {
+    mt19937 generator(14);
+    const vector<string> dictionary = {"cat"s, "dog"s, "bird"s, "city"s, "village"s, "big"s, "small"s, "orange"s,
+                                       "black"s, "white"s, "tail"s, "collar"s, "fluffy"s, "fancy"s, "starling"s, "and"s};
+    const auto random_text = [&generator, &dictionary](int word_count) {
+        string text;
+        for (int i = 0; i < word_count; ++i) {
+            text += dictionary[uniform_int_distribution<size_t>(0, dictionary.size() - 1)(generator)] + " "s;
+        }
+        return text;
+    };
+
+    SearchServer server("and"s);
+    ostringstream input;
+    for (int id = 500; id >= 0; --id) {
+        const string text = random_text(uniform_int_distribution(1, 8)(generator));
+        const DocumentStatus status = static_cast<DocumentStatus>(id % 4);
+        const vector<int> ratings = {id % 7 - 3, id % 11};
+        server.AddDocument(id, text, status, ratings);
+        WriteDocumentLine(input, id, status, ratings, text);
+    }
+    input << "\n"s;
+
+    SearchServer loaded_server("and"s);
+    loaded_server.AddDocument(1000, "fluffy starling"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(1000, "fluffy starling"s, DocumentStatus::ACTUAL, {1});
+    BulkLoadOptions options;
+    options.worker_count = 3;
+    options.chunk_size = 100;
+    options.max_queued_chunks = 2;
+    istringstream stream(input.str());
+    const BulkLoadStats stats = LoadDocuments(loaded_server, stream, options);
+    ASSERT_EQUAL_HINT(stats.document_count, 501u, "Bulk loaded document count error"s);
+    ASSERT_EQUAL_HINT(stats.byte_count, input.str().size(), "Bulk loaded byte count error"s);
+    ASSERT_EQUAL_HINT(loaded_server.GetDocumentCount(), server.GetDocumentCount(), "Bulk loader index size error"s);
+    for (int i = 0; i < 30; ++i) {
+        const string query = random_text(3) + "-"s + random_text(1);
+        for (const DocumentStatus status : {DocumentStatus::ACTUAL, DocumentStatus::BANNED}) {
+            const auto expected = server.FindTopDocuments(query, status, 10);
+            const auto found = loaded_server.FindTopDocuments(query, status, 10);
+            ASSERT_EQUAL_HINT(found.size(), expected.size(), "Bulk loader result size error"s);
+            for (size_t j = 0; j < found.size(); ++j) {
+                ASSERT_EQUAL_HINT(found[j].id, expected[j].id, "Bulk loader result error"s);
+                ASSERT_EQUAL_HINT(found[j].rating, expected[j].rating, "Bulk loader rating error"s);
+            }
+        }
+    }
+
+    // Ошибка в строке и повтор id не меняют индекс
+    for (const string& bad_input : {"1\tACTUAL\t1\tcat\n2\tUNKNOWN\t1\tdog\n"s, "1\tACTUAL\t1\tcat\n1\tACTUAL\t1\tdog\n"s,
+                                    "1\tACTUAL\tx\tcat\n"s, "1\tACTUAL\t1\tcat\n1000\tACTUAL\t1\tdog\n"s}) {
+        SearchServer target("and"s);
+        target.AddDocument(1000, "fluffy starling"s, DocumentStatus::ACTUAL, {1});
+        istringstream bad_stream(bad_input);
+        try {
+            LoadDocuments(target, bad_stream, options);
+            ASSERT_HINT(false, "Bulk loader accepted invalid input"s);
+        } catch (const invalid_argument&) {}
+        ASSERT_EQUAL_HINT(target.GetDocumentCount(), 1, "Bulk loader changed index on error"s);
+    }
+
+    // Нулевой размер блока не зацикливает чтение
+    options.chunk_size = 0;
+    SearchServer small_chunk_server("and"s);
+    istringstream small_chunk_stream("1\tACTUAL\t1\tcat\n2\tACTUAL\t1\tdog\n"s);
+    ASSERT_EQUAL_HINT(LoadDocuments(small_chunk_server, small_chunk_stream, options).document_count, 2u, "Zero chunk size load error"s);
+    // Исключение потока при чтении доходит до вызывающего, рабочие потоки завершаются
+    options.chunk_size = 100;
+    SearchServer failing_server("and"s);
+    istringstream failing_stream("1\tACTUAL\t1\tcat\n"s);
+    failing_stream.exceptions(ios::failbit);
+    try {
+        LoadDocuments(failing_server, failing_stream, options);
+        ASSERT_HINT(false, "Stream exception lost"s);
+    } catch (const ios::failure&) {}
+    ASSERT_EQUAL_HINT(failing_server.GetDocumentCount(), 0, "Bulk loader changed index on read error"s);
+
+    // Ошибка буфера посреди чтения без исключений потока не считается концом ввода
+    struct FailingBuffer : streambuf {
+        explicit FailingBuffer(string data)
+            : data(move(data)) {
+            setg(this->data.data(), this->data.data(), this->data.data() + this->data.size());
+        }
+        int_type underflow() override {
+            throw runtime_error("read error"s);
+        }
+        string data;
+    };
+    FailingBuffer failing_buffer("1\tACTUAL\t1\tcat\n2\tACTUAL\t1\tdog\n"s);
+    istream bad_stream(&failing_buffer);
+    SearchServer bad_stream_server("and"s);
+    try {
+        LoadDocuments(bad_stream_server, bad_stream, options);
+        ASSERT_HINT(false, "Stream read error lost"s);
+    } catch (const ios::failure&) {}
+    ASSERT_EQUAL_HINT(bad_stream_server.GetDocumentCount(), 0, "Bulk loader merged a failed stream"s);
+}
+
+void TestQueryArena() {
+    const size_t initial_capacity = QueryArena::GetCapacity();
+    {
+        QueryArena outer_arena;
+        pmr::vector<int> outer_numbers({1, 2, 3}, outer_arena.GetResource());
+        {
+            QueryArena inner_arena;
+            pmr::vector<char> large_block(initial_capacity * 2, 'x', inner_arena.GetResource());
+            ASSERT_EQUAL_HINT(large_block.back(), 'x', "Arena overflow allocation error"s);
+        }
+        ASSERT_HINT(outer_numbers == pmr::vector<int>({1, 2, 3}), "Nested arena released outer memory"s);
+        ASSERT_EQUAL_HINT(QueryArena::GetCapacity(), initial_capacity, "Arena grown before outer scope end"s);
+    }
+    ASSERT_HINT(QueryArena::GetCapacity() > initial_capacity * 2, "Arena did not grow after overflow"s);
+
+    SearchServer server("and"s);
+    server.AddDocument(1, "fluffy cat and fluffy tail"s, DocumentStatus::ACTUAL, {5});
+    server.AddDocument(2, "big dog"s, DocumentStatus::ACTUAL, {3});
+    for (int i = 0; i < 3; ++i) {
+        const auto documents = server.FindTopDocuments("fluffy dog -tail"s);
+        ASSERT_EQUAL_HINT(documents.size(), 1u, "Arena query result error"s);
+        ASSERT_EQUAL_HINT(documents[0].id, 2, "Arena query document error"s);
+    }
+
+    // Копия и присвоенный сервер строят индекс в своём пуле и не зависят от исходного
+    SearchServer copy = server;
+    SearchServer assigned("dog"s);
+    assigned.AddDocument(7, "white bird"s, DocumentStatus::ACTUAL, {1});
+    assigned = server;
+    server.RemoveDocument(2);
+    server.AddDocument(3, "white dog"s, DocumentStatus::ACTUAL, {1});
+    for (const SearchServer* target : {&copy, &assigned}) {
+        ASSERT_EQUAL_HINT(target->GetDocumentCount(), 2, "Copied server document count error"s);
+        const auto documents = target->FindTopDocuments("fluffy dog -tail"s);
+        ASSERT_HINT(documents.size() == 1u && documents[0].id == 2, "Copied server query error"s);
+    }
+    {
+        SearchServer temporary = copy;
+        assigned = move(temporary);
+    }
+    assigned.AddDocument(4, "black cat"s, DocumentStatus::ACTUAL, {1});
+    ASSERT_EQUAL_HINT(assigned.FindTopDocuments("cat"s).size(), 2u, "Move assigned server error"s);
+    ASSERT_HINT(assigned.GetVersion() > copy.GetVersion(), "Assignment must change the index version"s);
+}
+
+void TestRelevanceAccumulator() {
+    ASSERT_HINT(RelevanceAccumulator::ChooseStrategy(100, 50) == RelevanceAccumulator::Strategy::DENSE, "Dense strategy choice error"s);
+    ASSERT_HINT(RelevanceAccumulator::ChooseStrategy(1000000, 10) == RelevanceAccumulator::Strategy::HASH, "Hash strategy choice error"s);
+    for (const auto strategy : {RelevanceAccumulator::Strategy::DENSE, RelevanceAccumulator::Strategy::HASH}) {
+        QueryArena arena;
+        RelevanceAccumulator accumulator(strategy, 200, 6, arena.GetResource());
+        accumulator.Add(130, 0.5);
+        accumulator.Add(7, 1.0);
+        accumulator.Add(130, 0.25);
+        accumulator.Add(64, 0.0);
+        accumulator.Add(3, 2.0);
+        accumulator.Exclude(3);
+        accumulator.Exclude(199);
+        const pmr::vector<pair<int, double>> documents = accumulator.Extract();
+        const pmr::vector<pair<int, double>> expected = {{7, 1.0}, {64, 0.0}, {130, 0.75}};
+        ASSERT_HINT(documents == expected, "Accumulated relevance error"s);
+    }
+
+    // Редкие id выбирают хеш-таблицу, плотные - массив; результат тот же, что и у параллельного поиска
+    for (const int id_step : {1, 100000}) {
+        SearchServer server("and"s);
+        for (int i = 0; i < 50; ++i) {
+            server.AddDocument(i * id_step, (i % 2 ? "fluffy cat"s : "fluffy dog"s) + (i % 5 ? ""s : " tail"s),
+                               DocumentStatus::ACTUAL, {i});
+        }
+        const auto sequential = server.FindTopDocuments("fluffy cat -tail"s);
+        const auto parallel = server.FindTopDocuments(execution::par, "fluffy cat -tail"s);
+        ASSERT_EQUAL_HINT(sequential.size(), parallel.size(), "Accumulator result size error"s);
+        for (size_t i = 0; i < sequential.size(); ++i) {
+            ASSERT_EQUAL_HINT(sequential[i].id, parallel[i].id, "Accumulator result order error"s);
+            ASSERT_HINT(abs(sequential[i].relevance - parallel[i].relevance) < EPSILON, "Accumulator relevance error"s);
+            ASSERT_HINT(sequential[i].id % (5 * id_step) != 0, "Minus word not applied"s);
+        }
+    }
+}
+
+void TestDocumentOrdinals() {
+    // Старые вхождения удалённого документа не должны относиться к документам, добавленным после него
+    for (const QueryEvaluation query_evaluation : {QueryEvaluation::EXHAUSTIVE, QueryEvaluation::MAX_SCORE}) {
+        SearchServer server("and"s);
+        server.SetQueryEvaluation(query_evaluation);
+        server.AddDocument(10, "fluffy cat"s, DocumentStatus::ACTUAL, {1});
+        server.AddDocument(20, "black dog"s, DocumentStatus::BANNED, {2});
+        server.AddDocument(30, "fluffy dog"s, DocumentStatus::ACTUAL, {3});
+        server.RemoveDocument(20);
+        server.AddDocument(5, "orange cat"s, DocumentStatus::ACTUAL, {4});
+        ASSERT_EQUAL_HINT(server.GetDocumentCount(), 3, "Recycled document count error"s);
+        ASSERT_HINT(server.FindTopDocuments("black"s).empty() && server.FindTopDocuments("black"s, DocumentStatus::BANNED).empty(),
+                    "Removed document found through recycled ordinal"s);
+        const auto documents = server.FindTopDocuments("orange cat"s);
+        ASSERT_EQUAL_HINT(documents.size(), 2u, "Recycled document search error"s);
+        ASSERT_EQUAL_HINT(documents[0].id, 5, "Recycled document id error"s);
+        ASSERT_EQUAL_HINT(documents[0].rating, 4, "Recycled document rating error"s);
+        ASSERT_HINT(get<1>(server.MatchDocument("cat"s, 5)) == DocumentStatus::ACTUAL, "Recycled document status error"s);
+        ASSERT_EQUAL_HINT(server.FindTopDocuments("cat -orange"s)[0].id, 10, "Minus word on recycled ordinal error"s);
+        ASSERT_HINT(vector<int>(server.begin(), server.end()) == vector<int>({5, 10, 30}), "Document ids order error"s);
+
+        // Удаления и добавления вперемешку: перенумерация не меняет результаты
+        const vector<string> texts = {"fluffy cat"s, "black dog"s, "orange cat and dog"s, "white starling"s, "fluffy tail"s};
+        SearchServer churned("and"s);
+        churned.SetQueryEvaluation(query_evaluation);
+        churned.SetDuplicatePolicy(DuplicatePolicy::REPORT);
+        for (int id = 0; id < 200; ++id) {
+            churned.AddDocument(id, texts[id % texts.size()], static_cast<DocumentStatus>(id % 3), {id % 7});
+            if (id % 3 != 0) {
+                churned.RemoveDocument(id - 1);
+            }
+        }
+        SearchServer rebuilt("and"s);
+        rebuilt.SetQueryEvaluation(query_evaluation);
+        for (const int id : churned) {
+            rebuilt.AddDocument(id, texts[id % texts.size()], static_cast<DocumentStatus>(id % 3), {id % 7});
+        }
+        for (const string& query : {"cat"s, "fluffy dog"s, "dog -orange"s, "starling tail"s}) {
+            for (const DocumentStatus status : {DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT}) {
+                const auto expected = rebuilt.FindTopDocuments(query, status);
+                const auto found = churned.FindTopDocuments(query, status);
+                ASSERT_EQUAL_HINT(found.size(), expected.size(), "Renumbered result size error"s);
+                for (size_t i = 0; i < found.size(); ++i) {
+                    ASSERT_EQUAL_HINT(found[i].id, expected[i].id, "Renumbered result error"s);
+                    ASSERT_EQUAL_HINT(found[i].rating, expected[i].rating, "Renumbered rating error"s);
+                }
+            }
+        }
+        ASSERT_EQUAL_HINT(churned.GetOriginalId(199), churned.GetOriginalId(194), "Renumbered fingerprint index error"s);
+    }
+
+    // Равные документы упорядочены по id независимо от порядка добавления
+    SearchServer forward("and"s);
+    SearchServer backward("and"s);
+    for (int id = 0; id < 10; ++id) {
+        forward.AddDocument(id, "fluffy cat"s, DocumentStatus::ACTUAL, {1});
+        backward.AddDocument(9 - id, "fluffy cat"s, DocumentStatus::ACTUAL, {1});
+    }
+    const auto forward_documents = forward.FindTopDocuments("cat"s);
+    const auto backward_documents = backward.FindTopDocuments("cat"s);
+    ASSERT_EQUAL_HINT(forward_documents.size(), backward_documents.size(), "Tie result size error"s);
+    for (size_t i = 0; i < forward_documents.size(); ++i) {
+        ASSERT_EQUAL_HINT(forward_documents[i].id, static_cast<int>(i), "Tie order error"s);
+        ASSERT_EQUAL_HINT(backward_documents[i].id, static_cast<int>(i), "Tie order depends on insertion"s);
+    }
+}
+
+void TestStatusPrefilter() {
+    for (const QueryEvaluation query_evaluation : {QueryEvaluation::EXHAUSTIVE, QueryEvaluation::MAX_SCORE}) {
+        SearchServer server("and"s);
+        server.SetQueryEvaluation(query_evaluation);
+        for (int id = 0; id < 200; ++id) {
+            server.AddDocument(id, id % 3 ? "fluffy cat"s : "fluffy cat and dog"s, static_cast<DocumentStatus>(id % DOCUMENT_STATUS_COUNT), {id});
+        }
+        server.RemoveDocument(2);
+        server.AddDocument(1000, "fluffy cat"s, DocumentStatus::ACTUAL, {1000});
+
+        const auto banned = server.FindTopDocuments("cat"s, DocumentStatus::BANNED, 100);
+        ASSERT_EQUAL_HINT(banned.size(), 49u, "Status prefilter result size error"s);
+        ASSERT_HINT(all_of(banned.begin(), banned.end(), [](const Document& document) { return document.id % 4 == 2; }),
+                    "Status prefilter passed a wrong status"s);
+        const auto actual = server.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, 100);
+        ASSERT_EQUAL_HINT(actual.size(), 51u, "Recycled ordinal status error"s);
+        ASSERT_EQUAL_HINT(actual[0].id, 1000, "Recycled ordinal rating error"s);
+        if (query_evaluation == QueryEvaluation::EXHAUSTIVE) {
+            const auto stats = SearchServer::GetLastQueryStats();
+            ASSERT_HINT(stats.postings_scored == 51 && stats.postings_total == 200, "Status prefilter did not prune scoring"s);
+        }
+
+        // Фильтр по нескольким статусам вместе с предикатом; предикат видит только допустимые статусы
+        bool is_status_checked = true;
+        const auto documents = server.FindTopDocuments("cat -dog"s, StatusFilter{DocumentStatus::IRRELEVANT, DocumentStatus::REMOVED},
+                [&is_status_checked](int document_id, DocumentStatus status, [[maybe_unused]] int rating) {
+                    is_status_checked = is_status_checked && (status == DocumentStatus::IRRELEVANT || status == DocumentStatus::REMOVED);
+                    return document_id < 100;
+                }, 100);
+        ASSERT_HINT(is_status_checked, "Key mapper called for a filtered status"s);
+        const auto expected_count = count_if(server.begin(), server.end(), [](int id) {
+            return id < 100 && id % 2 == 1 && id % 3 != 0;
+        });
+        ASSERT_EQUAL_HINT(documents.size(), static_cast<size_t>(expected_count), "Multiple status filter error"s);
+        const auto parallel = server.FindTopDocuments(execution::par, "cat -dog"s, StatusFilter{DocumentStatus::IRRELEVANT, DocumentStatus::REMOVED},
+                [](int document_id, [[maybe_unused]] DocumentStatus status, [[maybe_unused]] int rating) { return document_id < 100; }, 100);
+        ASSERT_EQUAL_HINT(parallel.size(), documents.size(), "Parallel status filter error"s);
+    }
+}
+
+void TestIdfCache() {
+    SearchServer server("and"s);
+    for (int id = 0; id < 100; ++id) {
+        server.AddDocument(id, id % 4 ? "fluffy cat"s : "fluffy dog"s, DocumentStatus::ACTUAL, {1});
+    }
+    server.FindTopDocuments("cat dog"s);
+    ASSERT_EQUAL_HINT(SearchServer::GetLastQueryStats().idf_computed, 2u, "IDF not computed on first query"s);
+    const auto documents = server.FindTopDocuments("cat dog"s);
+    ASSERT_EQUAL_HINT(SearchServer::GetLastQueryStats().idf_computed, 0u, "IDF not taken from cache"s);
+    ASSERT_HINT(abs(documents.front().relevance - 0.5 * log(100.0 / 25)) < EPSILON, "Cached IDF error"s);
+
+    // Точный режим: любое изменение числа документов сбрасывает кэш
+    server.AddDocument(100, "big bird"s, DocumentStatus::ACTUAL, {1});
+    ASSERT_HINT(abs(server.FindTopDocuments("cat"s).back().relevance - 0.5 * log(101.0 / 75)) < EPSILON, "Stale IDF in exact mode"s);
+    ASSERT_EQUAL_HINT(SearchServer::GetLastQueryStats().idf_computed, 1u, "IDF not recomputed after write"s);
+
+    // Дрейф 5%: IDF по зафиксированному числу документов, но частота изменённого термина точна
+    server.SetIdfMaxDrift(0.05);
+    server.FindTopDocuments("cat dog"s);
+    for (int id = 101; id < 105; ++id) {
+        server.AddDocument(id, "big dog"s, DocumentStatus::ACTUAL, {1});
+    }
+    const auto drifted = server.FindTopDocuments("cat dog"s, DocumentStatus::ACTUAL, 200);
+    ASSERT_EQUAL_HINT(SearchServer::GetLastQueryStats().idf_computed, 1u, "Untouched term IDF recomputed within drift"s);
+    const auto cat_it = find_if(drifted.begin(), drifted.end(), [](const Document& document) { return document.id == 1; });
+    const auto dog_it = find_if(drifted.begin(), drifted.end(), [](const Document& document) { return document.id == 0; });
+    ASSERT_HINT(abs(cat_it->relevance - 0.5 * log(101.0 / 75)) < EPSILON, "Drift mode cat IDF error"s);
+    ASSERT_HINT(abs(dog_it->relevance - 0.5 * log(101.0 / 29)) < EPSILON, "Drift mode dog IDF error"s);
+    ASSERT_HINT(abs(cat_it->relevance - 0.5 * log(105.0 / 75)) < 0.5 * abs(log(1.0 - 0.05)), "Drift error bound exceeded"s);
+
+    server.AddDocument(105, "big bird"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(106, "big bird"s, DocumentStatus::ACTUAL, {1});
+    server.FindTopDocuments("cat"s);
+    ASSERT_EQUAL_HINT(SearchServer::GetLastQueryStats().idf_computed, 1u, "IDF cache not reset after drift"s);
+    ASSERT_HINT(abs(server.FindTopDocuments("cat"s).back().relevance - 0.5 * log(107.0 / 75)) < EPSILON, "IDF after drift reset error"s);
+
+    // Частота термина, выросшая в пределах дрейфа выше зафиксированного числа документов,
+    // не даёт отрицательного IDF, и MaxScore находит те же документы, что и полный перебор
+    SearchServer drift_server(""s);
+    for (int id = 1; id <= 10; ++id) {
+        drift_server.AddDocument(id, "a"s, DocumentStatus::ACTUAL, {1});
+    }
+    drift_server.SetIdfMaxDrift(0.5);
+    for (int id = 11; id <= 13; ++id) {
+        drift_server.AddDocument(id, "a b"s, DocumentStatus::ACTUAL, {1});
+    }
+    drift_server.AddDocument(14, "a"s, DocumentStatus::ACTUAL, {1});
+    drift_server.AddDocument(15, "b c c"s, DocumentStatus::ACTUAL, {1});
+    drift_server.SetQueryEvaluation(QueryEvaluation::EXHAUSTIVE);
+    const auto exhaustive = drift_server.FindTopDocuments("a b"s, DocumentStatus::ACTUAL, 3);
+    drift_server.SetQueryEvaluation(QueryEvaluation::MAX_SCORE);
+    const auto max_score = drift_server.FindTopDocuments("a b"s, DocumentStatus::ACTUAL, 3);
+    const double exact_relevance = 0.5 * log(15.0 / 14) + 0.5 * log(15.0 / 4);
+    ASSERT_EQUAL_HINT(exhaustive.front().id, 11, "Drift mode top document error"s);
+    ASSERT_HINT(abs(exhaustive.front().relevance - exact_relevance) <= abs(log(1.0 - 0.5)), "Drift error bound exceeded"s);
+    ASSERT_EQUAL_HINT(max_score.size(), exhaustive.size(), "MaxScore result count differs under drift"s);
+    for (size_t i = 0; i < exhaustive.size(); ++i) {
+        ASSERT_EQUAL_HINT(max_score[i].id, exhaustive[i].id, "MaxScore pruned a document under drift"s);
+        ASSERT_HINT(abs(max_score[i].relevance - exhaustive[i].relevance) < EPSILON, "MaxScore relevance differs under drift"s);
+    }
+    for (const Document& document : drift_server.FindTopDocuments("a"s, DocumentStatus::ACTUAL, 20)) {
+        ASSERT_HINT(document.relevance > -EPSILON, "Negative IDF under drift"s);
+    }
+}
+
+void TestQueryResultCache() {
+    SearchServer server("and in"s);
+    server.AddDocument(1, "fluffy cat"s, DocumentStatus::ACTUAL, {5});
+    server.AddDocument(2, "black dog"s, DocumentStatus::ACTUAL, {3});
+    server.AddDocument(3, "fluffy dog"s, DocumentStatus::BANNED, {1});
+    QueryResultCache cache(server, 2, 1);
+
+    const auto documents = cache.FindTopDocuments("fluffy dog"s);
+    ASSERT_EQUAL_HINT(documents.size(), 2u, "Cached search result error"s);
+    // Порядок, повторы, стоп-слова и неизвестные слова не меняют ключ
+    const auto same_documents = cache.FindTopDocuments("dog and fluffy dog parrot"s);
+    ASSERT_EQUAL_HINT(same_documents.size(), 2u, "Cache hit result error"s);
+    ASSERT_EQUAL_HINT(same_documents[0].id, documents[0].id, "Cache hit document error"s);
+    ASSERT_EQUAL_HINT(cache.GetStats().hit_count, 1u, "Normalized query missed cache"s);
+    cache.FindTopDocuments("fluffy dog"s, DocumentStatus::BANNED);
+    cache.FindTopDocuments("fluffy dog"s, DocumentStatus::ACTUAL, 1);
+    ASSERT_EQUAL_HINT(cache.GetStats().miss_count, 3u, "Status or result count shared a cache entry"s);
+    ASSERT_EQUAL_HINT(cache.size(), 2u, "Cache capacity exceeded"s);
+
+    // Изменение индекса делает сохранённые результаты устаревшими
+    server.AddDocument(4, "fluffy dog"s, DocumentStatus::ACTUAL, {9});
+    const auto updated = cache.FindTopDocuments("fluffy dog"s, DocumentStatus::ACTUAL, 1);
+    ASSERT_EQUAL_HINT(updated[0].id, 4, "Stale result served after AddDocument"s);
+    ASSERT_EQUAL_HINT(cache.GetStats().stale_count, 1u, "Stale entry not detected"s);
+    server.RemoveDocument(4);
+    ASSERT_EQUAL_HINT(cache.FindTopDocuments("fluffy dog"s, DocumentStatus::ACTUAL, 1)[0].id, 1, "Stale result served after RemoveDocument"s);
+
+    const auto is_rated = [](int, DocumentStatus, int rating) { return rating > 2; };
+    ASSERT_EQUAL_HINT(cache.FindTopDocuments("fluffy dog"s, 1, is_rated).size(), 2u, "Predicate search error"s);
+    ASSERT_EQUAL_HINT(cache.FindTopDocuments("dog fluffy"s, 1, is_rated).size(), 2u, "Predicate cache hit error"s);
+    const auto stats = cache.GetStats();
+    ASSERT_EQUAL_HINT(stats.hit_count, 2u, "Predicate id missed cache"s);
+    ASSERT_HINT(abs(stats.GetHitRate() - 2.0 / 8) < EPSILON, "Cache hit rate error"s);
+    ASSERT_HINT(stats.hit_latency_us > 0 && stats.miss_latency_us > 0, "Cache latency not recorded"s);
+}
+
+void TestDuplicateDetector() {
+    SearchServer server("and with"s);
+    server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(3, "curly hair with funny pet"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(4, "funny funny pet and nasty nasty rat"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(5, "funny pet and nasty rat cat"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(6, "nasty rat with curly hair"s, DocumentStatus::ACTUAL, {1});
+    const vector<int> exact_duplicates = DuplicateDetector().FindDuplicates(server);
+    const vector<int> expected_exact = {3, 4};
+    ASSERT_HINT(exact_duplicates == expected_exact, "Exact duplicates error"s);
+
+    // У документа 5 на одно слово больше, чем у документа 1: коэффициент Жаккара 4/5
+    const vector<int> near_duplicates = DuplicateDetector(0.75).FindDuplicates(server);
+    const vector<int> expected_near = {3, 4, 5};
+    ASSERT_HINT(near_duplicates == expected_near, "Near duplicates error"s);
+    ASSERT_HINT(DuplicateDetector(0.85).FindDuplicates(server) == expected_exact, "Near duplicate threshold error"s);
+    try {
+        DuplicateDetector(0.0);
+        ASSERT_HINT(false, "Zero Jaccard threshold accepted"s);
+    } catch (const invalid_argument&) {}
+
+    RemoveDuplicates(server, 0.75);
+    ASSERT_EQUAL_HINT(server.GetDocumentCount(), 3, "Near duplicates not removed"s);
+    ASSERT_HINT(server.HasDocument(1) && !server.HasDocument(5), "Lowest id not kept"s);
+}
+
+void TestDuplicatePolicy() {
+    SearchServer server("and with"s);
+    server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1});
+    server.SetDuplicatePolicy(DuplicatePolicy::REPORT);
+    server.AddDocument(5, "curly hair and funny funny pet"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(7, "nasty rat"s, DocumentStatus::ACTUAL, {1});
+    ASSERT_EQUAL_HINT(server.GetDocumentCount(), 3, "Reported duplicate not added"s);
+    ASSERT_EQUAL_HINT(server.GetOriginalId(5), 2, "Duplicate original error"s);
+    ASSERT_EQUAL_HINT(server.GetOriginalId(7), 7, "Unique document original error"s);
+    server.RemoveDocument(2);
+    ASSERT_EQUAL_HINT(server.GetOriginalId(5), 5, "Fingerprint index not updated on removal"s);
+
+    server.SetDuplicatePolicy(DuplicatePolicy::REJECT);
+    try {
+        server.AddDocument(8, "rat nasty"s, DocumentStatus::ACTUAL, {1});
+        ASSERT_HINT(false, "Duplicate accepted"s);
+    } catch (const invalid_argument&) {}
+    ASSERT_HINT(!server.HasDocument(8), "Rejected duplicate added"s);
+    // Дубликат с меньшим id заменяет документ 5
+    server.AddDocument(3, "pet curly hair funny"s, DocumentStatus::ACTUAL, {1});
+    ASSERT_HINT(server.HasDocument(3) && !server.HasDocument(5), "Lowest id not kept"s);
+    ASSERT_EQUAL_HINT(server.FindTopDocuments("curly"s).size(), 1u, "Replaced duplicate still found"s);
+    server.AddDocument(9, "funny rat"s, DocumentStatus::ACTUAL, {1});
+    ASSERT_EQUAL_HINT(server.GetDocumentCount(), 3, "Unique document rejected"s);
+
+    // Загрузка с REJECT: дубликаты внутри загрузки и с документами сервера
+    SearchServer loaded_server("and with"s);
+    loaded_server.AddDocument(4, "funny pet"s, DocumentStatus::ACTUAL, {1});
+    loaded_server.SetDuplicatePolicy(DuplicatePolicy::REJECT);
+    stringstream input;
+    WriteDocumentLine(input, 1, DocumentStatus::ACTUAL, {1}, "pet and funny"sv);
+    WriteDocumentLine(input, 2, DocumentStatus::ACTUAL, {1}, "nasty rat"sv);
+    WriteDocumentLine(input, 6, DocumentStatus::ACTUAL, {1}, "rat nasty rat"sv);
+    WriteDocumentLine(input, 7, DocumentStatus::ACTUAL, {1}, "curly hair"sv);
+    BulkLoadOptions options;
+    options.worker_count = 2;
+    options.chunk_size = 16;
+    LoadDocuments(loaded_server, input, options);
+    ASSERT_EQUAL_HINT(vector<int>(loaded_server.begin(), loaded_server.end()), (vector<int>{1, 2, 7}), "Bulk load duplicates not rejected"s);
+    ASSERT_EQUAL_HINT(loaded_server.FindTopDocuments("rat funny"s).size(), 2u, "Rejected duplicate indexed"s);
+}
+
+void TestRequestQueueStats() {
+    SearchServer search_server("и в на"s);
+    search_server.AddDocument(1, "пушистый кот пушистый хвост"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    RequestQueue request_queue(search_server, 3);
+    ASSERT_EQUAL_HINT(request_queue.GetLatencyPercentile(0.5), 0.0, "Empty window latency error"s);
+    request_queue.AddFindRequest("кот"s);
+    request_queue.AddFindRequest("пёс"s);
+    ASSERT_EQUAL_HINT(request_queue.GetRequestCount(), 2, "Request count error"s);
+    ASSERT_EQUAL_HINT(request_queue.GetHitRequests(), 1, "Hit count error"s);
+    request_queue.AddFindRequest("хвост"s);
+    request_queue.AddFindRequest("скворец"s);
+    // Запрос "кот" вытеснен из окна
+    ASSERT_EQUAL_HINT(request_queue.GetRequestCount(), 3, "Window size error"s);
+    ASSERT_EQUAL_HINT(request_queue.GetNoResultRequests(), 2, "No result count error"s);
+    const double median = request_queue.GetLatencyPercentile(0.5);
+    ASSERT_HINT(median > 0.0 && median <= request_queue.GetLatencyPercentile(1.0), "Latency percentile error"s);
+
+    // Из нескольких потоков: в окне остаются последние запросы, счётчики сходятся
+    RequestQueue concurrent_queue(search_server, 100);
+    vector<thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&concurrent_queue, i] {
+            for (int j = 0; j < 1000; ++j) {
+                concurrent_queue.AddFindRequest(i % 2 == 0 ? "кот"s : "пёс"s);
+            }
+        });
+    }
+    for (thread& worker : threads) {
+        worker.join();
+    }
+    ASSERT_EQUAL_HINT(concurrent_queue.GetRequestCount(), 100, "Concurrent window size error"s);
+    ASSERT_EQUAL_HINT(concurrent_queue.GetHitRequests() + concurrent_queue.GetNoResultRequests(), 100, "Concurrent counters error"s);
+}
+
+void TestMetrics() {
+    SearchServer server("и в на"s);
+    Metrics::SetEnabled(false);
+    Metrics::Reset();
+    server.AddDocument(1, "пушистый кот пушистый хвост"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    server.FindTopDocuments("кот"s);
+    ASSERT_EQUAL_HINT(Metrics::GetSnapshot().stages[static_cast<int>(MetricStage::PARSE)].count, 0u, "Disabled metrics recorded"s);
+
+    Metrics::SetEnabled(true);
+    server.AddDocument(2, "ухоженный пёс выразительные глаза"s, DocumentStatus::BANNED, {1});
+    // Документы, добавленные в другом потоке, учитываются и после его завершения
+    thread([&server] { server.AddDocument(3, "пушистый пёс"s, DocumentStatus::ACTUAL, {1}); }).join();
+    server.FindTopDocuments("пушистый пёс"s);
+    server.FindTopDocuments("пушистый пёс"s, DocumentStatus::BANNED);
+    server.SetQueryEvaluation(QueryEvaluation::MAX_SCORE);
+    server.FindTopDocuments("пушистый пёс"s);
+    server.RemoveDocument(3);
+    Metrics::SetEnabled(false);
+    const MetricsSnapshot snapshot = Metrics::GetSnapshot();
+    const auto count = [&snapshot](MetricStage stage) {
+        return snapshot.stages[static_cast<int>(stage)].count;
+    };
+    ASSERT_EQUAL_HINT(count(MetricStage::ADD_DOCUMENT), 2u, "AddDocument timing error"s);
+    ASSERT_EQUAL_HINT(count(MetricStage::REMOVE_DOCUMENT), 1u, "RemoveDocument timing error"s);
+    ASSERT_EQUAL_HINT(count(MetricStage::PARSE), 3u, "Parse timing error"s);
+    ASSERT_EQUAL_HINT(count(MetricStage::FILTER), 3u, "Filter timing error"s);
+    ASSERT_EQUAL_HINT(count(MetricStage::ACCUMULATE), 3u, "Accumulate timing error"s);
+    ASSERT_EQUAL_HINT(count(MetricStage::TOP_K), 2u, "Top-K timing error"s);
+    // Упорядочение найденных и результата при полном переборе, результата при MaxScore
+    ASSERT_EQUAL_HINT(count(MetricStage::SORT), 5u, "Sort timing error"s);
+    ASSERT_EQUAL_HINT(snapshot.counters[static_cast<int>(MetricCounter::DOCUMENTS_SCORED)], 5u, "Scored documents counter error"s);
+    ASSERT_HINT(snapshot.counters[static_cast<int>(MetricCounter::POSTINGS_SCANNED)] >= 5, "Scanned postings counter error"s);
+    const auto& parse_stats = snapshot.stages[static_cast<int>(MetricStage::PARSE)];
+    ASSERT_HINT(parse_stats.GetPercentileNs(0.5) <= parse_stats.GetPercentileNs(1.0), "Percentile order error"s);
+    ASSERT_HINT(snapshot.ToJson().find("\"add_document\":{\"count\":2"s) != string::npos, "JSON snapshot error"s);
+    ASSERT_HINT(snapshot.ToText().find("remove_document 1 "s) != string::npos, "Text snapshot error"s);
+    Metrics::Reset();
+    ASSERT_EQUAL_HINT(Metrics::GetSnapshot().stages[static_cast<int>(MetricStage::PARSE)].count, 0u, "Metrics reset error"s);
+}
+
+void TestCorpusGenerator() {
+    CorpusOptions options;
+    options.vocabulary_size = 1'000;
+    options.duplicate_ratio = 0.1;
+    const CorpusGenerator generator(options);
+    {
+        const CorpusGenerator same_generator(options);
+        ASSERT_EQUAL_HINT(generator.GenerateDocument(17).text, same_generator.GenerateDocument(17).text, "Same seed must give same documents"s);
+        ASSERT_EQUAL_HINT(generator.GenerateQuery(5, 3, 1), same_generator.GenerateQuery(5, 3, 1), "Same seed must give same queries"s);
+        options.seed = 43;
+        ASSERT_HINT(generator.GenerateDocument(17).text != CorpusGenerator(options).GenerateDocument(17).text, "Seed must change documents"s);
+        options.seed = 42;
+    }
+
+    const string stop_words_text = generator.GetStopWordsText();
+    const vector<string_view> stop_words = SplitIntoWords(stop_words_text);
+    ASSERT_EQUAL_HINT(stop_words.size(), options.stop_word_count, "Stop word count error"s);
+    const set<string_view> stop_word_set(stop_words.begin(), stop_words.end());
+    const int document_count = 2'000;
+    int word_count = 0;
+    int stop_word_count = 0;
+    int actual_count = 0;
+    for (int document_id = 0; document_id < document_count; ++document_id) {
+        const GeneratedDocument document = generator.GenerateDocument(document_id);
+        ASSERT_EQUAL(document.id, document_id);
+        ASSERT_HINT(!document.ratings.empty(), "Document without ratings"s);
+        for (const string_view word : SplitIntoWords(document.text)) {
+            ++word_count;
+            stop_word_count += stop_word_set.count(word);
+        }
+        actual_count += document.status == DocumentStatus::ACTUAL;
+    }
+    ASSERT_HINT(abs(static_cast<double>(stop_word_count) / word_count - options.stop_word_ratio) < 0.02, "Stop word ratio error"s);
+    ASSERT_HINT(abs(static_cast<double>(actual_count) / document_count - options.status_weights[0]) < 0.03, "Status weights error"s);
+
+    // При доле дубликатов 1 каждый документ повторяет множество слов документа 0
+    options.duplicate_ratio = 1.0;
+    const CorpusGenerator duplicate_generator(options);
+    const auto get_words = [](const string& text) {
+        const vector<string_view> words = SplitIntoWords(text);
+        return set<string>(words.begin(), words.end());
+    };
+    const set<string> original_words = get_words(duplicate_generator.GenerateDocument(0).text);
+    for (int document_id = 1; document_id < 10; ++document_id) {
+        ASSERT_HINT(get_words(duplicate_generator.GenerateDocument(document_id).text) == original_words, "Duplicate word set error"s);
+    }
+
+    const auto check_invalid = [](const CorpusOptions& invalid_options, const string& hint) {
+        try {
+            CorpusGenerator{invalid_options};
+            ASSERT_HINT(false, hint);
+        } catch (const invalid_argument&) {}
+    };
+    options = {};
+    options.min_document_length = 0;
+    check_invalid(options, "Empty document length must throw"s);
+    options = {};
+    options.stop_word_ratio = 1.5;
+    check_invalid(options, "Ratio above 1 must throw"s);
+    options = {};
+    options.status_weights = {0.0, 0.0, 0.0, 0.0};
+    check_invalid(options, "Zero status weights must throw"s);
+}
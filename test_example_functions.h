@@ -116,6 +116,49 @@ void TestPaginate();
 
 void TestQueue();
 
+void TestParallelExecution();
+
+void TestProcessQueries();
+
+void TestTermDictionary();
+
+void TestPostingList();
+
+void TestRemoveDocuments();
+
+void TestMaxResultCount();
+
+void TestMaxScoreEvaluation();
+
+void TestSplitIntoWords();
+
+void TestBoundaryScanners();
+
+void TestShardedSearchServer();
+
+void TestSnapshotSearchServer();
+
+void TestMappedSearchServer();
+
+void TestBulkLoader();
+
+void TestQueryArena();
+
+void TestRelevanceAccumulator();
+
+void TestDocumentOrdinals();
+
+void TestStatusPrefilter();
+
+void TestIdfCache();
+
+void TestQueryResultCache();
+void TestDuplicateDetector();
+void TestDuplicatePolicy();
+void TestRequestQueueStats();
+void TestMetrics();
+void TestCorpusGenerator();
+
 inline void TestSearchServer() {
     RUN_TEST(TestFindWordsFromAddedDocument);
     RUN_TEST(TestExcludeStopWordsFromAddedDocumentContent);
@@ -132,4 +175,28 @@ inline void TestSearchServer() {
     RUN_TEST(TestRemoveDuplicates);
     RUN_TEST(TestPaginate);
     RUN_TEST(TestQueue);
+    RUN_TEST(TestParallelExecution);
+    RUN_TEST(TestProcessQueries);
+    RUN_TEST(TestTermDictionary);
+    RUN_TEST(TestPostingList);
+    RUN_TEST(TestRemoveDocuments);
+    RUN_TEST(TestMaxResultCount);
+    RUN_TEST(TestMaxScoreEvaluation);
+    RUN_TEST(TestSplitIntoWords);
+    RUN_TEST(TestBoundaryScanners);
+    RUN_TEST(TestShardedSearchServer);
+    RUN_TEST(TestSnapshotSearchServer);
+    RUN_TEST(TestMappedSearchServer);
+    RUN_TEST(TestBulkLoader);
+    RUN_TEST(TestQueryArena);
+    RUN_TEST(TestRelevanceAccumulator);
+    RUN_TEST(TestDocumentOrdinals);
+    RUN_TEST(TestStatusPrefilter);
+    RUN_TEST(TestIdfCache);
+    RUN_TEST(TestQueryResultCache);
+    RUN_TEST(TestDuplicateDetector);
+    RUN_TEST(TestDuplicatePolicy);
+    RUN_TEST(TestRequestQueueStats);
+    RUN_TEST(TestMetrics);
+    RUN_TEST(TestCorpusGenerator);
 }